@@ -133,6 +133,8 @@ Consistency: {telemetry.get('consistency', 0.5):.2f}
 
 PIT STRATEGY:
 Optimal Pit Window: Lap {telemetry.get('optimal_pit_lap', 'Unknown')}
+Best Pit Lap From Here: {telemetry.get('best_pit_lap_from_here', 'Unknown')} (0 = no further stop; \
+{'clear' if telemetry.get('best_pit_lap_decisive') else 'close call'}, ±{telemetry.get('best_pit_lap_error_s', 0):.2f}s)
 
 RACE CONTEXT:
 Safety Car Probability: {race_context.get('safety_car_prob', 0.01):.2%}
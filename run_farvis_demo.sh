@@ -13,8 +13,26 @@ echo "Compiling C++ telemetry system..."
 g++ -std=c++17 -I src \
     src/main_gemini.cpp \
     src/telemetry/TelemetryGenerator.cpp \
+    src/telemetry/TickScheduler.cpp \
+    src/telemetry/Leaderboard.cpp \
+    src/physics/TickKernel.cpp \
     src/strategy/RaceSimulator.cpp \
     src/strategy/StrategyAnalyzer.cpp \
+    src/strategy/MultiStopOptimizer.cpp \
+    src/strategy/MonteCarloEvaluator.cpp \
+    src/strategy/StrategyCache.cpp \
+    src/strategy/LiveStrategyOptimizer.cpp \
+    src/strategy/ParameterSweep.cpp \
+    src/strategy/StrategySurrogate.cpp \
+    src/recording/TelemetryRecorder.cpp \
+    src/recording/ReplaySource.cpp \
+    src/recording/ColumnCodec.cpp \
+    src/recording/ArchiveWriter.cpp \
+    src/recording/ArchiveReader.cpp \
+    src/analytics/ScanKernel.cpp \
+    src/analytics/QueryEngine.cpp \
+    src/common/WorkStealingPool.cpp \
+    src/common/RaceModel.cpp \
     src/race-control/TrackLimitsMonitor.cpp \
     src/race-control/PenaltyEnforcer.cpp \
     -o f1-telemetry-gemini \
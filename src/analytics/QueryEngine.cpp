@@ -0,0 +1,339 @@
+#include "QueryEngine.h"
+#include <map>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+using namespace std;
+using namespace TelemetryArchive;
+
+struct QueryEngine::Plan {
+    uint32_t columns;                       // decoded for a chunk in the lap range
+    uint32_t edge_columns;                  // decoded for one outside it, to follow stints
+    vector<Column> measures;                // distinct columns the aggregates read
+    vector<size_t> select_measure;          // per select: index into measures (unused for COUNT)
+    vector<QueryPredicate> row_predicates;
+    vector<QueryPredicate> run_predicates;  // driver_id and lap
+    bool stints;
+};
+
+struct QueryEngine::ChunkResult {
+    // Rows of one driver and lap (and set of tyres) that passed the filter
+    struct Run {
+        uint32_t driver_id;
+        uint32_t lap;
+        uint32_t stint;   // tyre changes since the driver's first row in this chunk
+        uint32_t count;
+    };
+    // A driver's tyre wear at either end of the chunk, to number stints across chunks
+    struct DriverEdge {
+        uint32_t driver_id;
+        float first_wear;
+        float last_wear;
+        uint32_t tyre_changes;
+    };
+
+    vector<Run> runs;
+    vector<ScanKernel::RangeStats> stats;   // runs.size() x measures.size()
+    vector<DriverEdge> drivers;             // only when grouping by stint
+    uint64_t rows = 0;
+    bool scanned = false;
+    bool ok = true;
+};
+
+namespace {
+
+bool isMeasure(Column column) {
+    return column >= SPEED && column <= TIRE_TEMP_RR;
+}
+
+const float* measureColumn(const FrameColumns& columns, Column column) {
+    switch(column) {
+        case SPEED: return columns.speed_kph.data();
+        case THROTTLE: return columns.throttle.data();
+        case BRAKE: return columns.brake.data();
+        case TIRE_WEAR: return columns.tire_wear.data();
+        case TIRE_TEMP_FL:
+        case TIRE_TEMP_FR:
+        case TIRE_TEMP_RL:
+        case TIRE_TEMP_RR:
+            return columns.tire_temp_c[column - TIRE_TEMP_FL].data();
+        default:
+            return nullptr;
+    }
+}
+
+// Whether any lap in [min_lap, max_lap] can pass the predicate
+bool lapRangeMayMatch(const QueryPredicate& predicate, uint32_t min_lap, uint32_t max_lap) {
+    const double low = min_lap;
+    const double high = max_lap;
+    const double value = predicate.value;
+    switch(predicate.op) {
+        case ScanKernel::Compare::LESS: return low < value;
+        case ScanKernel::Compare::LESS_EQUAL: return low <= value;
+        case ScanKernel::Compare::GREATER: return high > value;
+        case ScanKernel::Compare::GREATER_EQUAL: return high >= value;
+        case ScanKernel::Compare::EQUAL: return low <= value && value <= high;
+        case ScanKernel::Compare::NOT_EQUAL: return !(low == high && low == value);
+    }
+    return true;
+}
+
+struct Accumulator {
+    uint64_t count = 0;
+    double sum_lap = 0.0;          // least-squares terms, with the lap as x
+    double sum_lap_squared = 0.0;
+    vector<double> sum;            // per measure
+    vector<double> sum_lap_value;
+    vector<float> min;
+    vector<float> max;
+};
+
+} // namespace
+
+QueryEngine::QueryEngine(WorkStealingPool& pool)
+    : pool_(pool), stats_{} {
+}
+
+bool QueryEngine::validate(const Query& query) const {
+    if(query.select.empty()) return false;
+    if(query.group_by & ~(GROUP_RACE | GROUP_DRIVER | GROUP_LAP | GROUP_STINT)) return false;
+    for(const QuerySelect& select : query.select) {
+        if(select.aggregate != QueryAggregate::COUNT && !isMeasure(select.column)) return false;
+    }
+    for(const QueryPredicate& predicate : query.where) {
+        const Column c = predicate.column;
+        if(!isMeasure(c) && c != DRIVER_ID && c != LAP && c != SECTOR && c != RACE_POSITION) return false;
+    }
+    return true;
+}
+
+void QueryEngine::scanChunk(const Plan& plan, const ArchiveReader& race, size_t chunk, FrameColumns& columns,
+                            vector<uint32_t>& mask, ChunkResult& result) const {
+    const ChunkHeader header = race.chunkHeader(chunk);
+    bool in_range = true;
+    for(const QueryPredicate& predicate : plan.run_predicates) {
+        if(predicate.column == LAP && !lapRangeMayMatch(predicate, header.min_lap, header.max_lap)) in_range = false;
+    }
+    // A skipped chunk can still hold a tyre change, so stint numbering reads its edges
+    if(!in_range && !plan.stints) return;
+    if(!race.decodeChunk(chunk, columns, in_range ? plan.columns : plan.edge_columns)) {
+        result.ok = false;
+        return;
+    }
+
+    const size_t n = columns.size();
+    result.scanned = in_range;
+    result.rows = in_range ? n : 0;
+    if(n == 0) return;
+
+    const uint32_t* selection = nullptr;
+    if(in_range && !plan.row_predicates.empty()) {
+        mask.assign(n, ScanKernel::SELECTED);
+        for(const QueryPredicate& predicate : plan.row_predicates) {
+            if(predicate.column == SECTOR) {
+                ScanKernel::filter(columns.sector.data(), n, predicate.op, predicate.value, mask.data());
+            } else if(predicate.column == RACE_POSITION) {
+                ScanKernel::filter(columns.race_position.data(), n, predicate.op, predicate.value, mask.data());
+            } else {
+                ScanKernel::filter(measureColumn(columns, predicate.column), n, predicate.op, predicate.value,
+                                   mask.data());
+            }
+        }
+        selection = mask.data();
+    }
+
+    const uint32_t* driver = columns.driver_id.data();
+    const uint32_t* lap = columns.lap.data();
+    const float* wear = columns.tire_wear.data();
+    vector<const float*> measures;
+    for(Column column : plan.measures) measures.push_back(measureColumn(columns, column));
+
+    uint32_t stint = 0;
+    size_t begin = 0;
+    for(size_t i = 1; i <= n; i++) {
+        if(i < n && driver[i] == driver[i - 1] && lap[i] == lap[i - 1] && !(plan.stints && wear[i] < wear[i - 1])) {
+            continue;
+        }
+
+        if(plan.stints) {
+            if(begin == 0 || driver[begin] != driver[begin - 1]) {
+                result.drivers.push_back({driver[begin], wear[begin], wear[begin], 0});
+                stint = 0;
+            } else if(wear[begin] < wear[begin - 1]) {
+                stint++;
+                result.drivers.back().tyre_changes++;
+            }
+            result.drivers.back().last_wear = wear[i - 1];
+        }
+
+        bool run_selected = in_range;
+        for(const QueryPredicate& predicate : plan.run_predicates) {
+            const uint32_t key = predicate.column == LAP ? lap[begin] : driver[begin];
+            if(!ScanKernel::compare(static_cast<float>(key), predicate.op, predicate.value)) run_selected = false;
+        }
+        if(run_selected) {
+            const size_t first_stats = result.stats.size();
+            uint32_t count;
+            if(measures.empty()) {
+                count = ScanKernel::countSelected(selection, begin, i);
+            } else {
+                for(const float* values : measures) {
+                    result.stats.push_back(ScanKernel::summarize(values, selection, begin, i));
+                }
+                count = result.stats[first_stats].count;
+            }
+            if(count > 0) {
+                result.runs.push_back({driver[begin], lap[begin], stint, count});
+            } else {
+                result.stats.resize(first_stats);
+            }
+        }
+        begin = i;
+    }
+}
+
+bool QueryEngine::run(const Query& query, const vector<const ArchiveReader*>& races, vector<QueryRow>& rows) {
+    stats_ = Stats{};
+    rows.clear();
+    if(!validate(query)) return false;
+
+    Plan plan;
+    plan.stints = (query.group_by & GROUP_STINT) != 0;
+    plan.columns = columnBit(DRIVER_ID) | columnBit(LAP);
+    plan.edge_columns = columnBit(DRIVER_ID) | columnBit(LAP) | columnBit(TIRE_WEAR);
+    if(plan.stints) plan.columns |= columnBit(TIRE_WEAR);
+    for(const QuerySelect& select : query.select) {
+        if(select.aggregate == QueryAggregate::COUNT) {
+            plan.select_measure.push_back(0);
+            continue;
+        }
+        auto it = find(plan.measures.begin(), plan.measures.end(), select.column);
+        plan.select_measure.push_back(it - plan.measures.begin());
+        if(it == plan.measures.end()) plan.measures.push_back(select.column);
+        plan.columns |= columnBit(select.column);
+    }
+    for(const QueryPredicate& predicate : query.where) {
+        if(predicate.column == DRIVER_ID || predicate.column == LAP) {
+            plan.run_predicates.push_back(predicate);
+        } else {
+            plan.row_predicates.push_back(predicate);
+            plan.columns |= columnBit(predicate.column);
+        }
+    }
+
+    struct Task {
+        uint32_t race;
+        size_t chunk;
+    };
+    vector<Task> tasks;
+    for(uint32_t r = 0; r < races.size(); r++) {
+        if(!races[r] || !races[r]->isOpen()) return false;
+        for(size_t c = 0; c < races[r]->chunkCount(); c++) tasks.push_back({r, c});
+    }
+
+    vector<ChunkResult> results(tasks.size());
+    TaskGroup group;
+    for(size_t begin = 0; begin < tasks.size(); begin += CHUNKS_PER_JOB) {
+        pool_.submit(group, [&, begin]() {
+            FrameColumns columns;
+            vector<uint32_t> mask;
+            const size_t end = min(tasks.size(), begin + CHUNKS_PER_JOB);
+            for(size_t t = begin; t < end; t++) {
+                scanChunk(plan, *races[tasks[t].race], tasks[t].chunk, columns, mask, results[t]);
+            }
+        });
+    }
+    group.wait();
+
+    // Merged in chunk order: each driver's stints are numbered as its tyres changed
+    struct StintState {
+        uint32_t stint = 1;
+        float last_wear = 0.0f;
+        bool seen = false;
+    };
+    vector<vector<StintState>> stint_state(races.size());
+    vector<uint32_t> stint_base;
+    map<array<uint32_t, 4>, Accumulator> groups;
+    const size_t measure_count = plan.measures.size();
+
+    for(size_t t = 0; t < tasks.size(); t++) {
+        const ChunkResult& result = results[t];
+        const uint32_t race = tasks[t].race;
+        if(!result.ok) return false;
+        if(result.scanned) stats_.chunks_scanned++;
+        else stats_.chunks_skipped++;
+        stats_.rows_scanned += result.rows;
+
+        if(plan.stints) {
+            vector<StintState>& state = stint_state[race];
+            state.resize(races[race]->driverCount());
+            stint_base.assign(state.size(), 1);
+            for(const ChunkResult::DriverEdge& edge : result.drivers) {
+                if(edge.driver_id >= state.size()) return false;
+                StintState& s = state[edge.driver_id];
+                if(s.seen && edge.first_wear < s.last_wear) s.stint++;
+                stint_base[edge.driver_id] = s.stint;
+                s.stint += edge.tyre_changes;
+                s.last_wear = edge.last_wear;
+                s.seen = true;
+            }
+        }
+
+        for(size_t r = 0; r < result.runs.size(); r++) {
+            const ChunkResult::Run& run = result.runs[r];
+            const array<uint32_t, 4> key = {
+                (query.group_by & GROUP_RACE) ? race : 0,
+                (query.group_by & GROUP_DRIVER) ? run.driver_id : 0,
+                (query.group_by & GROUP_LAP) ? run.lap : 0,
+                plan.stints ? stint_base[run.driver_id] + run.stint : 0};
+
+            Accumulator& acc = groups[key];
+            if(acc.sum.empty() && measure_count > 0) {
+                acc.sum.assign(measure_count, 0.0);
+                acc.sum_lap_value.assign(measure_count, 0.0);
+                acc.min.assign(measure_count, numeric_limits<float>::infinity());
+                acc.max.assign(measure_count, -numeric_limits<float>::infinity());
+            }
+            const double x = run.lap;
+            acc.count += run.count;
+            acc.sum_lap += x * run.count;
+            acc.sum_lap_squared += x * x * run.count;
+            for(size_t m = 0; m < measure_count; m++) {
+                const ScanKernel::RangeStats& s = result.stats[r * measure_count + m];
+                acc.sum[m] += s.sum;
+                acc.sum_lap_value[m] += x * s.sum;
+                acc.min[m] = min(acc.min[m], s.min);
+                acc.max[m] = max(acc.max[m], s.max);
+            }
+            stats_.rows_matched += run.count;
+        }
+    }
+
+    rows.reserve(groups.size());
+    for(const auto& entry : groups) {
+        const Accumulator& acc = entry.second;
+        QueryRow row{entry.first[0], entry.first[1], entry.first[2], entry.first[3], {}};
+        const double n = static_cast<double>(acc.count);
+        for(size_t s = 0; s < query.select.size(); s++) {
+            const size_t m = plan.select_measure[s];
+            double value = 0.0;
+            switch(query.select[s].aggregate) {
+                case QueryAggregate::COUNT: value = n; break;
+                case QueryAggregate::MIN: value = acc.min[m]; break;
+                case QueryAggregate::MAX: value = acc.max[m]; break;
+                case QueryAggregate::AVG: value = acc.sum[m] / n; break;
+                case QueryAggregate::SUM: value = acc.sum[m]; break;
+                case QueryAggregate::SLOPE: {
+                    const double spread = n * acc.sum_lap_squared - acc.sum_lap * acc.sum_lap;
+                    value = spread > 0.0 ? (n * acc.sum_lap_value[m] - acc.sum_lap * acc.sum[m]) / spread : NAN;
+                    break;
+                }
+            }
+            row.values.push_back(value);
+        }
+        rows.push_back(move(row));
+    }
+    return true;
+}
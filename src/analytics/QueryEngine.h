@@ -0,0 +1,97 @@
+#pragma once
+
+#include "../common/WorkStealingPool.h"
+#include "../recording/ArchiveReader.h"
+#include "ScanKernel.h"
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Row filter: column op value. Float measurements, sector and race_position are
+// tested per row; driver_id and lap per (driver, lap) run, and lap bounds also skip
+// whole chunks through their headers.
+struct QueryPredicate {
+    TelemetryArchive::Column column;
+    ScanKernel::Compare op;
+    float value;
+};
+
+enum class QueryAggregate : uint8_t {
+    COUNT,   // column ignored
+    MIN,
+    MAX,
+    AVG,
+    SUM,
+    SLOPE,   // least-squares change per lap, e.g. kph lost per lap over a stint
+};
+
+struct QuerySelect {
+    QueryAggregate aggregate;
+    TelemetryArchive::Column column;   // a float measurement (speed .. tire_temp_rr)
+};
+
+// Group-by keys, combined as a mask
+enum QueryGroup : uint32_t {
+    GROUP_RACE = 1u << 0,     // which archive
+    GROUP_DRIVER = 1u << 1,
+    GROUP_LAP = 1u << 2,
+    GROUP_STINT = 1u << 3,    // per driver, numbered from 1; a new set of tyres starts the next
+};
+
+// SELECT select FROM races WHERE where[0] AND ... GROUP BY group_by. Groups no row
+// passes the filter for are left out.
+struct Query {
+    std::vector<QuerySelect> select;
+    std::vector<QueryPredicate> where;
+    uint32_t group_by = 0;
+};
+
+struct QueryRow {
+    // Keys not in the group-by are 0
+    uint32_t race;
+    uint32_t driver_id;
+    uint32_t lap;
+    uint32_t stint;
+    std::vector<double> values;   // one per Query::select; SLOPE is NaN over a single lap
+};
+
+// Runs filter / group-by / aggregate queries over recorded races (one TelemetryArchive
+// each) without expanding them back into frames.
+//
+// Every archive chunk is a row group. Chunks are spread across the pool, each job
+// decoding only the columns the query touches and scanning them with ScanKernel:
+// the predicates build a row selection, then each run of rows sharing (driver, lap)
+// - contiguous, since chunks are stored driver-major - is reduced to partial
+// aggregates in one masked pass per column. The partials are merged in chunk order
+// on the calling thread, so results don't depend on the thread count.
+class QueryEngine {
+public:
+    struct Stats {
+        uint64_t chunks_scanned;
+        uint64_t chunks_skipped;   // lap range outside the predicates
+        uint64_t rows_scanned;
+        uint64_t rows_matched;
+    };
+
+    explicit QueryEngine(WorkStealingPool& pool = WorkStealingPool::shared());
+
+    // Rows sorted by (race, driver, lap, stint). False if the query is invalid (a
+    // column the operation doesn't support) or a chunk is corrupt.
+    bool run(const Query& query, const std::vector<const ArchiveReader*>& races, std::vector<QueryRow>& rows);
+
+    // Of the last run()
+    Stats stats() const { return stats_; }
+
+private:
+    struct Plan;
+    struct ChunkResult;
+
+    bool validate(const Query& query) const;
+    void scanChunk(const Plan& plan, const ArchiveReader& race, size_t chunk, FrameColumns& columns,
+                   std::vector<uint32_t>& mask, ChunkResult& result) const;
+
+    WorkStealingPool& pool_;
+    Stats stats_;
+
+    static constexpr size_t CHUNKS_PER_JOB = 4;
+};
@@ -0,0 +1,213 @@
+#include "ScanKernel.h"
+#include <limits>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define SCAN_KERNEL_X86 1
+#include <immintrin.h>
+#endif
+
+namespace ScanKernel {
+
+namespace {
+
+constexpr float INF = std::numeric_limits<float>::infinity();
+
+// Both paths keep eight running lanes (row begin + 8j + k goes to lane k) and fold
+// them in the same order, so their sums come out bit-identical.
+struct Lanes {
+    double sum[8];
+    float min[8];
+    float max[8];
+    uint32_t count;
+};
+
+void initLanes(Lanes& lanes) {
+    for (int k = 0; k < 8; k++) {
+        lanes.sum[k] = 0.0;
+        lanes.min[k] = INF;
+        lanes.max[k] = -INF;
+    }
+    lanes.count = 0;
+}
+
+// Folds the lanes, then adds rows [tail, end) one at a time.
+RangeStats foldLanes(const Lanes& lanes, const float* values, const uint32_t* mask, size_t tail, size_t end) {
+    RangeStats stats{lanes.count, INF, -INF, 0.0};
+    for (int k = 0; k < 8; k++) {
+        stats.sum += lanes.sum[k];
+        stats.min = lanes.min[k] < stats.min ? lanes.min[k] : stats.min;
+        stats.max = lanes.max[k] > stats.max ? lanes.max[k] : stats.max;
+    }
+    for (size_t i = tail; i < end; i++) {
+        if (mask && !mask[i]) continue;
+        stats.count++;
+        stats.sum += values[i];
+        stats.min = values[i] < stats.min ? values[i] : stats.min;
+        stats.max = values[i] > stats.max ? values[i] : stats.max;
+    }
+    return stats;
+}
+
+void filterTail(const float* values, size_t begin, size_t n, Compare op, float operand, uint32_t* mask) {
+    for (size_t i = begin; i < n; i++) {
+        if (!compare(values[i], op, operand)) mask[i] = 0;
+    }
+}
+
+#ifdef SCAN_KERNEL_X86
+template<int PREDICATE>
+__attribute__((target("avx2")))
+void filterBlocks(const float* values, size_t blocks_end, float operand, uint32_t* mask) {
+    const __m256 threshold = _mm256_set1_ps(operand);
+    for (size_t i = 0; i < blocks_end; i += 8) {
+        const __m256 pass = _mm256_cmp_ps(_mm256_loadu_ps(values + i), threshold, PREDICATE);
+        float* m = reinterpret_cast<float*>(mask + i);
+        _mm256_storeu_ps(m, _mm256_and_ps(_mm256_loadu_ps(m), pass));
+    }
+}
+
+void filterAvx2(const float* values, size_t n, Compare op, float operand, uint32_t* mask) {
+    const size_t blocks_end = n & ~size_t(7);
+    switch (op) {
+        case Compare::LESS: filterBlocks<_CMP_LT_OQ>(values, blocks_end, operand, mask); break;
+        case Compare::LESS_EQUAL: filterBlocks<_CMP_LE_OQ>(values, blocks_end, operand, mask); break;
+        case Compare::GREATER: filterBlocks<_CMP_GT_OQ>(values, blocks_end, operand, mask); break;
+        case Compare::GREATER_EQUAL: filterBlocks<_CMP_GE_OQ>(values, blocks_end, operand, mask); break;
+        case Compare::EQUAL: filterBlocks<_CMP_EQ_OQ>(values, blocks_end, operand, mask); break;
+        case Compare::NOT_EQUAL: filterBlocks<_CMP_NEQ_UQ>(values, blocks_end, operand, mask); break;
+    }
+    filterTail(values, blocks_end, n, op, operand, mask);
+}
+
+__attribute__((target("avx2")))
+RangeStats summarizeAvx2(const float* values, const uint32_t* mask, size_t begin, size_t end) {
+    const __m256 inf = _mm256_set1_ps(INF);
+    const __m256 negative_inf = _mm256_set1_ps(-INF);
+    __m256d sum_low = _mm256_setzero_pd();    // lanes 0-3
+    __m256d sum_high = _mm256_setzero_pd();   // lanes 4-7
+    __m256 min = inf;
+    __m256 max = negative_inf;
+    __m256i count = _mm256_setzero_si256();
+
+    size_t i = begin;
+    for (; i + 8 <= end; i += 8) {
+        __m256 x = _mm256_loadu_ps(values + i);
+        __m256 low = x;
+        __m256 high = x;
+        if (mask) {
+            const __m256 m = _mm256_loadu_ps(reinterpret_cast<const float*>(mask + i));
+            count = _mm256_sub_epi32(count, _mm256_castps_si256(m));   // all ones is -1
+            x = _mm256_and_ps(x, m);
+            low = _mm256_blendv_ps(inf, low, m);
+            high = _mm256_blendv_ps(negative_inf, high, m);
+        }
+        sum_low = _mm256_add_pd(sum_low, _mm256_cvtps_pd(_mm256_castps256_ps128(x)));
+        sum_high = _mm256_add_pd(sum_high, _mm256_cvtps_pd(_mm256_extractf128_ps(x, 1)));
+        min = _mm256_min_ps(low, min);
+        max = _mm256_max_ps(high, max);
+    }
+
+    Lanes lanes;
+    _mm256_storeu_pd(lanes.sum, sum_low);
+    _mm256_storeu_pd(lanes.sum + 4, sum_high);
+    _mm256_storeu_ps(lanes.min, min);
+    _mm256_storeu_ps(lanes.max, max);
+    if (mask) {
+        uint32_t counts[8];
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(counts), count);
+        lanes.count = 0;
+        for (int k = 0; k < 8; k++) lanes.count += counts[k];
+    } else {
+        lanes.count = static_cast<uint32_t>(i - begin);
+    }
+    return foldLanes(lanes, values, mask, i, end);
+}
+
+bool hasAvx2() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+#endif
+
+using FilterFn = void (*)(const float*, size_t, Compare, float, uint32_t*);
+using SummarizeFn = RangeStats (*)(const float*, const uint32_t*, size_t, size_t);
+
+struct Dispatch {
+    FilterFn filter;
+    SummarizeFn summarize;
+    const char* isa;
+};
+
+Dispatch resolve() {
+#ifdef SCAN_KERNEL_X86
+    if (hasAvx2()) return {filterAvx2, summarizeAvx2, "avx2"};
+#endif
+    return {filterScalar, summarizeScalar, "scalar"};
+}
+
+const Dispatch dispatch = resolve();
+
+} // namespace
+
+bool compare(float value, Compare op, float operand) {
+    switch (op) {
+        case Compare::LESS: return value < operand;
+        case Compare::LESS_EQUAL: return value <= operand;
+        case Compare::GREATER: return value > operand;
+        case Compare::GREATER_EQUAL: return value >= operand;
+        case Compare::EQUAL: return value == operand;
+        case Compare::NOT_EQUAL: return value != operand;
+    }
+    return false;
+}
+
+void filter(const float* values, size_t n, Compare op, float operand, uint32_t* mask) {
+    dispatch.filter(values, n, op, operand, mask);
+}
+
+void filter(const uint8_t* values, size_t n, Compare op, float operand, uint32_t* mask) {
+    // Sector and race position only; a lookup over the 256 possible values keeps it branch-free
+    uint32_t pass[256];
+    for (int v = 0; v < 256; v++) pass[v] = compare(static_cast<float>(v), op, operand) ? SELECTED : 0;
+    for (size_t i = 0; i < n; i++) mask[i] &= pass[values[i]];
+}
+
+RangeStats summarize(const float* values, const uint32_t* mask, size_t begin, size_t end) {
+    return dispatch.summarize(values, mask, begin, end);
+}
+
+uint32_t countSelected(const uint32_t* mask, size_t begin, size_t end) {
+    if (!mask) return static_cast<uint32_t>(end - begin);
+    uint32_t count = 0;
+    for (size_t i = begin; i < end; i++) count += mask[i] & 1;
+    return count;
+}
+
+void filterScalar(const float* values, size_t n, Compare op, float operand, uint32_t* mask) {
+    filterTail(values, 0, n, op, operand, mask);
+}
+
+RangeStats summarizeScalar(const float* values, const uint32_t* mask, size_t begin, size_t end) {
+    Lanes lanes;
+    initLanes(lanes);
+    size_t i = begin;
+    for (; i + 8 <= end; i += 8) {
+        for (int k = 0; k < 8; k++) {
+            const bool selected = !mask || mask[i + k];
+            const float x = values[i + k];
+            lanes.count += selected;
+            lanes.sum[k] += selected ? x : 0.0f;
+            const float low = selected ? x : INF;
+            const float high = selected ? x : -INF;
+            lanes.min[k] = low < lanes.min[k] ? low : lanes.min[k];
+            lanes.max[k] = high > lanes.max[k] ? high : lanes.max[k];
+        }
+    }
+    return foldLanes(lanes, values, mask, i, end);
+}
+
+const char* activeIsa() {
+    return dispatch.isa;
+}
+
+} // namespace ScanKernel
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Vectorized column scans for QueryEngine: predicate filters that build a row
+// selection, and masked min/max/sum over a row range. AVX2 when the CPU has it,
+// scalar otherwise (chosen once at runtime); both give bit-identical results.
+//
+// A selection is one uint32_t per row, all ones (selected) or zero, so it can be
+// loaded straight into a vector register as a lane mask.
+namespace ScanKernel {
+
+    enum class Compare : uint8_t {
+        LESS,
+        LESS_EQUAL,
+        GREATER,
+        GREATER_EQUAL,
+        EQUAL,
+        NOT_EQUAL,
+    };
+
+    constexpr uint32_t SELECTED = 0xFFFFFFFFu;
+
+    struct RangeStats {
+        uint32_t count;   // selected rows; min/max are +inf/-inf when zero
+        float min;
+        float max;
+        double sum;
+    };
+
+    bool compare(float value, Compare op, float operand);
+
+    // mask[i] is cleared unless values[i] op operand, for i < n.
+    void filter(const float* values, size_t n, Compare op, float operand, uint32_t* mask);
+    void filter(const uint8_t* values, size_t n, Compare op, float operand, uint32_t* mask);
+
+    // Over the selected rows of [begin, end); mask == nullptr selects all of them.
+    RangeStats summarize(const float* values, const uint32_t* mask, size_t begin, size_t end);
+    uint32_t countSelected(const uint32_t* mask, size_t begin, size_t end);
+
+    // Exposed so callers can cross-check the two paths.
+    void filterScalar(const float* values, size_t n, Compare op, float operand, uint32_t* mask);
+    RangeStats summarizeScalar(const float* values, const uint32_t* mask, size_t begin, size_t end);
+    const char* activeIsa();
+}
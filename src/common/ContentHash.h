@@ -0,0 +1,31 @@
+#pragma once
+
+#include "CounterRng.h"
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// Incremental hash for content keys (RaceModel::contentHash, StrategyCache entries):
+// FNV-1a over the raw bytes fed in, finalized with the SplitMix64 mix so nearby
+// inputs land far apart. Not cryptographic; floats are hashed by bit pattern.
+class ContentHash {
+public:
+    void bytes(const void* data, size_t n) {
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        for(size_t i = 0; i < n; i++) {
+            h_ ^= p[i];
+            h_ *= 0x100000001b3ULL;
+        }
+    }
+    void u32(uint32_t v) { bytes(&v, sizeof(v)); }
+    void f32(float v) { bytes(&v, sizeof(v)); }
+    void str(const std::string& s) {
+        u32(static_cast<uint32_t>(s.size()));
+        bytes(s.data(), s.size());
+    }
+
+    uint64_t finish() const { return CounterRng::mix(h_); }
+
+private:
+    uint64_t h_ = 0xcbf29ce484222325ULL;
+};
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <cmath>
+
+// Counter-based random numbers: every draw is a pure hash of (seed, stream,
+// counter), so there is no generator state to share or hand out. Any thread can
+// reproduce draw #k of trial #t directly, which makes parallel Monte Carlo runs
+// identical regardless of how trials are split across threads.
+namespace CounterRng {
+
+    // SplitMix64 finalizer; full avalanche, so adjacent counters are uncorrelated.
+    inline uint64_t mix(uint64_t x) {
+        x += 0x9e3779b97f4a7c15ULL;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+
+    inline uint64_t bits(uint64_t seed, uint64_t stream, uint64_t counter) {
+        return mix(mix(mix(seed) ^ stream) ^ counter);
+    }
+
+    // Uniform in [0, 1)
+    inline double uniform(uint64_t seed, uint64_t stream, uint64_t counter) {
+        return (bits(seed, stream, counter) >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    // Standard normal (Box-Muller on two draws: counters 2k and 2k+1)
+    inline double normal(uint64_t seed, uint64_t stream, uint64_t counter) {
+        const double u1 = 1.0 - uniform(seed, stream, 2 * counter);   // (0, 1], safe for log
+        const double u2 = uniform(seed, stream, 2 * counter + 1);
+        return std::sqrt(-2.0 * std::log(u1)) * std::cos(6.283185307179586 * u2);
+    }
+}
@@ -0,0 +1,109 @@
+#include "RaceModel.h"
+#include "ContentHash.h"
+#include <algorithm>
+
+using namespace std;
+
+shared_ptr<const RaceModel> RaceModel::create(const TrackProfile& track,
+                                              const vector<DriverProfile>& drivers,
+                                              const vector<CarProfile>& cars,
+                                              uint32_t total_laps) {
+    shared_ptr<RaceModel> model(new RaceModel());
+    const size_t n = drivers.size();
+    const size_t floats_per_line = sizeof(CacheLine) / sizeof(float);
+
+    model->track_ = track;
+    model->total_laps_ = total_laps;
+    model->driver_count_ = n;
+    model->stride_ = max<size_t>(1, (n + floats_per_line - 1) / floats_per_line) * floats_per_line;
+    model->storage_.assign(model->stride_ / floats_per_line * COLUMN_COUNT, CacheLine{});
+
+    float* aggression = model->column(AGGRESSION);
+    float* consistency = model->column(CONSISTENCY);
+    float* engine_power = model->column(ENGINE_POWER);
+    float* reliability = model->column(RELIABILITY);
+    float* base_speed = model->column(BASE_SPEED);
+    float* wear_per_lap = model->column(WEAR_PER_LAP);
+    float* pit_threshold = model->column(PIT_THRESHOLD);
+    float* pit_loss = model->column(PIT_LOSS);
+
+    model->driver_name_.resize(n);
+    model->car_name_.resize(n);
+    for(size_t i = 0; i < n; i++) {
+        const auto& driver = drivers[i];
+        const auto& car = cars[i];
+
+        aggression[i] = driver.aggression;
+        consistency[i] = driver.consistency;
+        engine_power[i] = car.engine_power;
+        reliability[i] = car.reliability;
+
+        base_speed[i] = baseSpeedFor(car.engine_power, driver.consistency);
+        wear_per_lap[i] = wearPerLapFor(driver.aggression, track.tire_wear_factor);
+        pit_threshold[i] = pitThresholdFor(driver.tire_management, driver.risk_tolerance);
+        pit_loss[i] = pitLossFor(car.reliability);
+
+        model->driver_name_[i] = model->intern(driver.driver_id);
+        model->car_name_[i] = model->intern(car.car_id);
+    }
+
+    ContentHash hasher;
+    hasher.u32(track.track_id);
+    hasher.u32(track.sectors);
+    hasher.f32(track.lap_length_km);
+    hasher.f32(track.tire_wear_factor);
+    hasher.f32(track.overtaking_difficulty);
+    hasher.f32(track.safety_car_probability);
+    hasher.u32(total_laps);
+    hasher.u32(static_cast<uint32_t>(n));
+    for(size_t i = 0; i < n; i++) {
+        hasher.str(drivers[i].driver_id);
+        hasher.f32(aggression[i]);
+        hasher.f32(consistency[i]);
+        hasher.f32(drivers[i].tire_management);
+        hasher.f32(drivers[i].risk_tolerance);
+        hasher.str(cars[i].car_id);
+        hasher.f32(engine_power[i]);
+        hasher.f32(cars[i].aero_efficiency);
+        hasher.f32(cars[i].cooling_efficiency);
+        hasher.f32(reliability[i]);
+    }
+    model->content_hash_ = hasher.finish();
+
+    return model;
+}
+
+float RaceModel::baseSpeedFor(float engine_power, float consistency) {
+    // Speed based on driver skill and car performance
+    float driver_skill = 0.80f + consistency * 0.25f;
+    return 220.0f * engine_power * driver_skill;
+}
+
+float RaceModel::wearPerLapFor(float aggression, float tire_wear_factor) {
+    // Tire wear scales with distance traveled (not per tick), so pit timing stays stable if sim speed changes.
+    // Tuned so typical first stops fall roughly in the 15–25 lap range depending on driver traits and track.
+    return WEAR_PER_LAP_PER_AGGRESSION * aggression * tire_wear_factor;
+}
+
+float RaceModel::aggressionForWearPerLap(float wear_per_lap, float tire_wear_factor) {
+    return wear_per_lap / (WEAR_PER_LAP_PER_AGGRESSION * tire_wear_factor);
+}
+
+float RaceModel::pitThresholdFor(float tire_management, float risk_tolerance) {
+    float base_threshold = 0.65f + (tire_management * 0.25f);
+    float risk_adjustment = (risk_tolerance - 0.5f) * 0.15f;
+    return base_threshold + risk_adjustment;
+}
+
+float RaceModel::pitLossFor(float reliability) {
+    return 2.0f + (1.0f - reliability) * 1.0f;
+}
+
+uint32_t RaceModel::intern(const string& name) {
+    // A couple dozen names at most; a linear scan beats hashing here
+    for(uint32_t i = 0; i < names_.size(); i++) {
+        if(names_[i] == name) return i;
+    }
+    names_.push_back(name);
+    return static_cast<uint32_t>(names_.size() - 1);
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "types.h"
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+// Everything a race is built from, frozen at creation and shared by reference
+// count: the track, total_laps, the driver/car profile numbers the simulation
+// reads and the per-driver constants the physics derives from them.
+// Simulators, the generator and race control all hold the same shared_ptr, so
+// spinning up another simulator copies nothing.
+//
+// Profile numbers are stored column-wise (one float array per field, indexed by
+// driver id) in a single 64-byte-aligned block; names live in a separate
+// interned table, so the hot arrays never touch a std::string.
+class RaceModel {
+public:
+    static std::shared_ptr<const RaceModel> create(const TrackProfile& track,
+                                                   const std::vector<DriverProfile>& drivers,
+                                                   const std::vector<CarProfile>& cars,
+                                                   uint32_t total_laps);
+
+    size_t driverCount() const { return driver_count_; }
+    const TrackProfile& track() const { return track_; }
+    uint32_t totalLaps() const { return total_laps_; }
+    float sectorLengthKm() const { return track_.lap_length_km / track_.sectors; }
+
+    // Profile columns
+    const float* aggression() const { return column(AGGRESSION); }
+    const float* consistency() const { return column(CONSISTENCY); }
+    const float* enginePower() const { return column(ENGINE_POWER); }
+    const float* reliability() const { return column(RELIABILITY); }
+
+    // Derived per driver
+    const float* baseSpeed() const { return column(BASE_SPEED); }         // kph on fresh tires
+    const float* wearPerLap() const { return column(WEAR_PER_LAP); }
+    const float* pitThreshold() const { return column(PIT_THRESHOLD); }   // wear that triggers a stop
+    const float* pitLossSeconds() const { return column(PIT_LOSS); }
+
+    const std::string& driverName(uint32_t driver_id) const { return names_[driver_name_[driver_id]]; }
+    const std::string& carName(uint32_t driver_id) const { return names_[car_name_[driver_id]]; }
+
+    // The derivations behind the columns above, for callers (e.g. parameter sweeps)
+    // that need them for profile values other than the model's own.
+    static float baseSpeedFor(float engine_power, float consistency);
+    static float wearPerLapFor(float aggression, float tire_wear_factor);
+    // Inverse of wearPerLapFor: the aggression that wears tires at wear_per_lap.
+    static float aggressionForWearPerLap(float wear_per_lap, float tire_wear_factor);
+    static float pitThresholdFor(float tire_management, float risk_tolerance);
+    static float pitLossFor(float reliability);
+
+    // Hash of every input field, computed once; identical inputs give identical hashes.
+    uint64_t contentHash() const { return content_hash_; }
+
+private:
+    enum Column {
+        AGGRESSION, CONSISTENCY, ENGINE_POWER, RELIABILITY,
+        BASE_SPEED, WEAR_PER_LAP, PIT_THRESHOLD, PIT_LOSS,
+        COLUMN_COUNT
+    };
+
+    struct alignas(64) CacheLine {
+        float values[16];
+    };
+
+    static constexpr float WEAR_PER_LAP_PER_AGGRESSION = 0.05f;
+
+    RaceModel() = default;
+
+    const float* column(Column c) const { return storage_.data()->values + c * stride_; }
+    float* column(Column c) { return storage_.data()->values + c * stride_; }
+    uint32_t intern(const std::string& name);
+
+    TrackProfile track_;
+    uint32_t total_laps_;
+    size_t driver_count_;
+    size_t stride_;   // floats per column, rounded up to whole cache lines
+
+    std::vector<CacheLine> storage_;
+
+    std::vector<std::string> names_;
+    std::vector<uint32_t> driver_name_;
+    std::vector<uint32_t> car_name_;
+
+    uint64_t content_hash_;
+};
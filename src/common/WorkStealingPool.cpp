@@ -0,0 +1,127 @@
+#include "WorkStealingPool.h"
+
+using namespace std;
+
+namespace {
+    // Index of the pool worker running on this thread, or SIZE_MAX elsewhere
+    thread_local const WorkStealingPool* current_pool = nullptr;
+    thread_local size_t current_worker = SIZE_MAX;
+}
+
+void TaskGroup::wait() {
+    unique_lock<mutex> lock(mutex_);
+    cv_done_.wait(lock, [this]() {
+        return completed_.load(memory_order_acquire) == submitted_.load(memory_order_acquire);
+    });
+}
+
+bool TaskGroup::waitFor(chrono::milliseconds timeout) {
+    unique_lock<mutex> lock(mutex_);
+    return cv_done_.wait_for(lock, timeout, [this]() {
+        return completed_.load(memory_order_acquire) == submitted_.load(memory_order_acquire);
+    });
+}
+
+void TaskGroup::finishOne() {
+    // Notify under the lock so a waiter can't miss the last completion
+    lock_guard<mutex> lock(mutex_);
+    completed_.fetch_add(1, memory_order_acq_rel);
+    cv_done_.notify_all();
+}
+
+WorkStealingPool::WorkStealingPool(size_t threads) : next_worker_(0), queued_(0), stopping_(false) {
+    if(threads == 0) threads = thread::hardware_concurrency();
+    if(threads == 0) threads = 2;
+
+    for(size_t i = 0; i < threads; i++) {
+        workers_.push_back(make_unique<Worker>());
+    }
+    // Start only once every deque exists, since workers steal from each other
+    for(size_t i = 0; i < threads; i++) {
+        workers_[i]->thread = thread([this, i]() { run(i); });
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        lock_guard<mutex> lock(idle_mutex_);
+        stopping_ = true;
+    }
+    cv_work_.notify_all();
+    for(auto& worker : workers_) {
+        worker->thread.join();
+    }
+}
+
+WorkStealingPool& WorkStealingPool::shared() {
+    static WorkStealingPool pool;
+    return pool;
+}
+
+void WorkStealingPool::submit(TaskGroup& group, function<void()> job) {
+    group.submitted_.fetch_add(1, memory_order_acq_rel);
+
+    // Jobs spawned from a worker stay local (cache-warm); others are dealt round-robin
+    size_t index = (current_pool == this) ? current_worker
+                                          : next_worker_.fetch_add(1, memory_order_relaxed) % workers_.size();
+    {
+        // Count before publishing, so a thief can never drive queued_ below zero
+        lock_guard<mutex> lock(idle_mutex_);
+        queued_.fetch_add(1, memory_order_release);
+    }
+    {
+        lock_guard<mutex> lock(workers_[index]->mutex);
+        workers_[index]->jobs.push_back({&group, move(job)});
+    }
+    cv_work_.notify_one();
+}
+
+bool WorkStealingPool::tryTake(size_t index, Job& job) {
+    {
+        Worker& own = *workers_[index];
+        lock_guard<mutex> lock(own.mutex);
+        if(!own.jobs.empty()) {
+            job = move(own.jobs.back());
+            own.jobs.pop_back();
+            return true;
+        }
+    }
+
+    for(size_t k = 1; k < workers_.size(); k++) {
+        Worker& victim = *workers_[(index + k) % workers_.size()];
+        lock_guard<mutex> lock(victim.mutex);
+        if(!victim.jobs.empty()) {
+            job = move(victim.jobs.front());
+            victim.jobs.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::execute(Job& job) {
+    if(!job.group->cancelled()) {
+        job.fn();
+    }
+    job.group->finishOne();
+}
+
+void WorkStealingPool::run(size_t index) {
+    current_pool = this;
+    current_worker = index;
+
+    while(true) {
+        Job job;
+        if(tryTake(index, job)) {
+            queued_.fetch_sub(1, memory_order_acq_rel);
+            execute(job);
+            continue;
+        }
+
+        unique_lock<mutex> lock(idle_mutex_);
+        cv_work_.wait(lock, [this]() {
+            return queued_.load(memory_order_acquire) > 0 || stopping_;
+        });
+        if(stopping_ && queued_.load(memory_order_acquire) == 0) return;
+    }
+}
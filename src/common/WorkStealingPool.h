@@ -0,0 +1,89 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <cstddef>
+
+// Tracks one batch of jobs submitted to a WorkStealingPool: completion,
+// progress and cooperative cancellation. Cancelling skips jobs that haven't
+// started; jobs already running can poll cancelled() and bail out early.
+class TaskGroup {
+public:
+    void cancel() { cancelled_.store(true, std::memory_order_relaxed); }
+    bool cancelled() const { return cancelled_.load(std::memory_order_relaxed); }
+
+    size_t submitted() const { return submitted_.load(std::memory_order_acquire); }
+    // Finished or skipped jobs
+    size_t completed() const { return completed_.load(std::memory_order_acquire); }
+
+    // Blocks until every submitted job has finished or been skipped.
+    // Don't call from inside a job of the same pool.
+    void wait();
+    // As wait(), but gives up after timeout; returns true once everything is done.
+    bool waitFor(std::chrono::milliseconds timeout);
+
+private:
+    friend class WorkStealingPool;
+
+    void finishOne();
+
+    std::atomic<size_t> submitted_{0};
+    std::atomic<size_t> completed_{0};
+    std::atomic<bool> cancelled_{false};
+    std::mutex mutex_;
+    std::condition_variable cv_done_;
+};
+
+// Fixed set of worker threads, each with its own job deque. A worker takes new
+// work from the back of its own deque and, when that runs dry, steals from the
+// front of the others', so a batch of uneven jobs keeps every core busy until
+// the whole batch is done. Threads live for the pool's lifetime; submitting a
+// job never creates one.
+class WorkStealingPool {
+public:
+    // threads == 0 sizes the pool to the hardware
+    explicit WorkStealingPool(size_t threads = 0);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    void submit(TaskGroup& group, std::function<void()> job);
+
+    size_t threadCount() const { return workers_.size(); }
+
+    // Process-wide pool for analysis work, created on first use.
+    static WorkStealingPool& shared();
+
+private:
+    struct Job {
+        TaskGroup* group;
+        std::function<void()> fn;
+    };
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+        std::thread thread;
+    };
+
+    void run(size_t index);
+    bool tryTake(size_t index, Job& job);
+    void execute(Job& job);
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<size_t> next_worker_;
+
+    // Sleep/wake for idle workers; queued_ counts jobs not yet taken.
+    std::mutex idle_mutex_;
+    std::condition_variable cv_work_;
+    std::atomic<size_t> queued_;
+    bool stopping_;
+};
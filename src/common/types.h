@@ -2,6 +2,7 @@
 
 #include <cstdint>
 #include <string>
+#include <vector>
 
 struct CarProfile {
     std::string car_id;
@@ -23,14 +24,12 @@ struct DriverProfile {
     float risk_tolerance; // willingness to pit under uncertainty
 };
 
+// Widest fields first so the frame packs into 56 bytes instead of 64.
 struct TelemetryFrame {
-    uint8_t race_position;
-
     uint64_t timestamp_ns;
 
     uint32_t driver_id;
     uint32_t lap;
-    uint8_t  sector;
 
     // Vehicle state
     float speed_kph;
@@ -40,6 +39,9 @@ struct TelemetryFrame {
     // Tires
     float tire_temp_c[4];      // FL, FR, RL, RR
     float tire_wear;           // 0.0 (new) – 1.0 (dead)
+
+    uint8_t race_position;
+    uint8_t sector;
 };
 
 struct TrackProfile {
@@ -64,4 +66,11 @@ struct DriverState {
     bool has_pitted;  // Prevent re-triggering a planned/optimal pit stop
     uint64_t pit_stop_start_time_ns;
     uint64_t pit_stop_end_time_ns;
-};
\ No newline at end of file
+};
+
+// Copy of the whole field's live state at one instant, for planners that run
+// off the producer thread.
+struct RaceSnapshot {
+    uint64_t timestamp_ns;
+    std::vector<DriverState> states;
+};
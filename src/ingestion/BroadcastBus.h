@@ -0,0 +1,248 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <type_traits>
+#include <thread>
+
+// How a subscriber waits once it has caught up with the producer:
+//   PARK:            sleep on the bus's condition variable straight away
+//   SPIN_THEN_PARK:  poll the published counter for a short while first, then park;
+//                    a tick that arrives within the spin is picked up without a wakeup
+enum class WaitStrategy {
+    PARK,
+    SPIN_THEN_PARK
+};
+
+// Single-producer broadcast ring (disruptor style).
+// The producer publishes each item once and never waits for anyone. Every
+// subscriber owns its own cursor and reads on its own thread; a subscriber that
+// falls more than `capacity` items behind is lapped: it skips ahead to the oldest
+// item still in the ring and the skipped count is recorded, instead of
+// back-pressuring the producer or the other subscribers.
+template<typename T>
+class BroadcastBus {
+    static_assert(std::is_trivially_copyable<T>::value, "BroadcastBus slots are copied optimistically");
+
+public:
+    class Subscriber {
+    public:
+        // Blocks until at least one item is available, then copies up to max items
+        // in publish order. Returns 0 once the bus is shut down and fully read, or
+        // once cancelled.
+        size_t next(T* out, size_t max);
+
+        // Safe from any thread: wakes a blocked next(), and every next() from then on
+        // returns 0, leaving the rest unread.
+        void cancel();
+
+        uint64_t lapped() const { return lapped_; }
+        // How far this subscriber has read; safe to poll from the producer thread.
+        uint64_t consumed() const { return consumed_.load(std::memory_order_acquire); }
+
+    private:
+        friend class BroadcastBus;
+        Subscriber(BroadcastBus* bus, uint64_t cursor, WaitStrategy wait_strategy)
+            : bus_(bus), cursor_(cursor), lapped_(0), consumed_(cursor), cancelled_(false),
+              wait_strategy_(wait_strategy) {}
+
+        // True once there is something for next() to do
+        bool ready() const;
+
+        BroadcastBus* bus_;
+        uint64_t cursor_;    // sequence of the next item to read
+        uint64_t lapped_;    // items overwritten before this subscriber could read them
+        std::atomic<uint64_t> consumed_;
+        std::atomic<bool> cancelled_;
+        WaitStrategy wait_strategy_;
+    };
+
+    explicit BroadcastBus(size_t capacity);
+
+    // Subscribers only see items published after they subscribe.
+    Subscriber subscribe(WaitStrategy wait_strategy = WaitStrategy::PARK);
+
+    void publish(const T& item);
+    // A whole tick at once: the items are written, then made visible with a single
+    // counter store and at most one wakeup. Subscribers drain them with next(out, max).
+    void publishBatch(const T* items, size_t count);
+
+    void shutdown();
+
+    uint64_t published() const { return published_.load(std::memory_order_acquire); }
+    size_t capacity() const { return capacity_; }
+
+private:
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+    static constexpr int SPIN_ITERATIONS = 2000;
+
+    struct Slot {
+        // Seqlock version: 2*seq+1 while being written, 2*seq+2 once item seq is complete.
+        std::atomic<uint64_t> version;
+        T value;
+    };
+
+    static size_t roundUpToPowerOfTwo(size_t n);
+
+    void writeSlot(uint64_t seq, const T& item);
+    bool readSlot(uint64_t seq, T& out) const;
+    void wakeSubscribers();
+
+    std::vector<Slot> slots_;
+    size_t capacity_;
+    size_t mask_;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> published_;  // number of items published
+
+    alignas(CACHE_LINE_SIZE) std::atomic<int> waiting_;
+    std::atomic<bool> shutdown_;
+    std::mutex wait_mutex_;
+    std::condition_variable cv_published_;
+};
+
+template<typename T>
+size_t BroadcastBus<T>::roundUpToPowerOfTwo(size_t n) {
+    size_t p = 1;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+template<typename T>
+BroadcastBus<T>::BroadcastBus(size_t capacity)
+    : slots_(roundUpToPowerOfTwo(capacity < 2 ? 2 : capacity)),
+      capacity_(slots_.size()),
+      mask_(slots_.size() - 1),
+      published_(0), waiting_(0), shutdown_(false) {
+    for (auto& slot : slots_) {
+        slot.version.store(0, std::memory_order_relaxed);
+    }
+}
+
+template<typename T>
+typename BroadcastBus<T>::Subscriber BroadcastBus<T>::subscribe(WaitStrategy wait_strategy) {
+    return Subscriber(this, published_.load(std::memory_order_acquire), wait_strategy);
+}
+
+template<typename T>
+void BroadcastBus<T>::writeSlot(uint64_t seq, const T& item) {
+    Slot& slot = slots_[seq & mask_];
+    slot.version.store(2 * seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.value = item;
+    slot.version.store(2 * seq + 2, std::memory_order_release);
+}
+
+template<typename T>
+bool BroadcastBus<T>::readSlot(uint64_t seq, T& out) const {
+    const Slot& slot = slots_[seq & mask_];
+    const uint64_t before = slot.version.load(std::memory_order_acquire);
+    if (before != 2 * seq + 2) return false;
+    out = slot.value;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot.version.load(std::memory_order_relaxed) == before;
+}
+
+template<typename T>
+void BroadcastBus<T>::wakeSubscribers() {
+    if (waiting_.load(std::memory_order_seq_cst) > 0) {
+        std::lock_guard<std::mutex> lock(wait_mutex_);
+        cv_published_.notify_all();
+    }
+}
+
+template<typename T>
+void BroadcastBus<T>::publish(const T& item) {
+    publishBatch(&item, 1);
+}
+
+template<typename T>
+void BroadcastBus<T>::publishBatch(const T* items, size_t count) {
+    if (count == 0 || shutdown_.load(std::memory_order_relaxed)) return;
+
+    const uint64_t seq = published_.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < count; i++) {
+        writeSlot(seq + i, items[i]);
+    }
+    // seq_cst pairs with waiting_ so a subscriber about to sleep can't miss this batch.
+    published_.store(seq + count, std::memory_order_seq_cst);
+    wakeSubscribers();
+}
+
+template<typename T>
+void BroadcastBus<T>::shutdown() {
+    std::lock_guard<std::mutex> lock(wait_mutex_);
+    shutdown_.store(true, std::memory_order_seq_cst);
+    cv_published_.notify_all();
+}
+
+template<typename T>
+size_t BroadcastBus<T>::Subscriber::next(T* out, size_t max) {
+    if (max == 0) return 0;
+
+    while (true) {
+        if (cancelled_.load(std::memory_order_acquire)) return 0;
+
+        const uint64_t published = bus_->published_.load(std::memory_order_acquire);
+
+        if (published - cursor_ > bus_->capacity_) {
+            // Lapped: the producer has already reused the slots we hadn't read.
+            lapped_ += published - cursor_ - bus_->capacity_;
+            cursor_ = published - bus_->capacity_;
+        }
+
+        size_t copied = 0;
+        while (copied < max && cursor_ < published) {
+            if (!bus_->readSlot(cursor_, out[copied])) {
+                // Overwritten while we were reading; re-check how far behind we are.
+                break;
+            }
+            cursor_++;
+            copied++;
+        }
+        if (copied > 0) {
+            consumed_.store(cursor_, std::memory_order_release);
+            return copied;
+        }
+        if (cursor_ < published) {
+            continue; // lapped mid-read, retry from the new oldest item
+        }
+
+        if (bus_->shutdown_.load(std::memory_order_acquire)) {
+            if (bus_->published_.load(std::memory_order_acquire) == cursor_) return 0;
+            continue;
+        }
+
+        if (wait_strategy_ == WaitStrategy::SPIN_THEN_PARK) {
+            bool arrived = false;
+            for (int i = 0; i < SPIN_ITERATIONS && !arrived; i++) {
+                arrived = ready();
+                if ((i & 63) == 63) std::this_thread::yield();
+            }
+            if (arrived) continue;
+        }
+
+        std::unique_lock<std::mutex> lock(bus_->wait_mutex_);
+        bus_->waiting_.fetch_add(1, std::memory_order_seq_cst);
+        bus_->cv_published_.wait(lock, [this]() { return ready(); });
+        bus_->waiting_.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+template<typename T>
+bool BroadcastBus<T>::Subscriber::ready() const {
+    return bus_->published_.load(std::memory_order_seq_cst) != cursor_ ||
+           bus_->shutdown_.load(std::memory_order_seq_cst) ||
+           cancelled_.load(std::memory_order_seq_cst);
+}
+
+template<typename T>
+void BroadcastBus<T>::Subscriber::cancel() {
+    // Under the wait mutex, so a subscriber between its checks and wait() can't miss it
+    std::lock_guard<std::mutex> lock(bus_->wait_mutex_);
+    cancelled_.store(true, std::memory_order_seq_cst);
+    bus_->cv_published_.notify_all();
+}
@@ -0,0 +1,246 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <condition_variable>
+
+// What push() does when the consumer falls behind.
+//   BLOCK:        wait for space (lossless, but a slow consumer stalls the producer)
+//   DROP_NEWEST:  discard the incoming item
+//   DROP_OLDEST:  evict the oldest queued item to make room
+//   CONFLATE:     keep only the newest item per key; never blocks, never grows past one slot per key
+enum class BackpressurePolicy {
+    BLOCK,
+    DROP_NEWEST,
+    DROP_OLDEST,
+    CONFLATE
+};
+
+// Parses "block", "drop-newest", "drop-oldest" or "conflate"; anything else yields fallback.
+inline BackpressurePolicy parseBackpressurePolicy(const char* name, BackpressurePolicy fallback) {
+    if (!name) return fallback;
+    if (std::strcmp(name, "block") == 0) return BackpressurePolicy::BLOCK;
+    if (std::strcmp(name, "drop-newest") == 0) return BackpressurePolicy::DROP_NEWEST;
+    if (std::strcmp(name, "drop-oldest") == 0) return BackpressurePolicy::DROP_OLDEST;
+    if (std::strcmp(name, "conflate") == 0) return BackpressurePolicy::CONFLATE;
+    return fallback;
+}
+
+struct IngestionStats {
+    uint64_t pushed;
+    uint64_t dropped;     // discarded by DROP_NEWEST / DROP_OLDEST
+    uint64_t conflated;   // overwritten in place by CONFLATE
+};
+
+// Bounded producer/consumer queue with a selectable backpressure policy.
+// Items are keyed by their driver_id member for CONFLATE. Unlike the old
+// "pop then push" fallback in the mains, eviction happens under the queue's
+// own lock, so the producer never races the consumer.
+template<typename T>
+class IngestionQueue {
+public:
+    // A capacity of 0 is treated as 1.
+    IngestionQueue(size_t capacity, BackpressurePolicy policy);
+
+    bool push(const T& item);
+    bool pop(T& item);
+
+    size_t pushBatch(const T* items, size_t count);
+    size_t popBatch(T* out, size_t max);
+
+    void shutdown();
+
+    BackpressurePolicy policy() const { return policy_; }
+    IngestionStats stats() const;
+
+private:
+    bool pushLocked(const T& item, std::unique_lock<std::mutex>& lock);
+    bool emptyLocked() const;
+    T takeLocked();
+
+    BackpressurePolicy policy_;
+    size_t capacity_;
+
+    // FIFO storage for BLOCK / DROP_NEWEST / DROP_OLDEST
+    std::vector<T> buffer_;
+    size_t head_;
+    size_t tail_;
+    size_t size_;
+
+    // CONFLATE: latest item per key plus the order keys became pending
+    std::vector<T> latest_;
+    std::vector<bool> pending_;
+    std::vector<uint32_t> pending_keys_;   // FIFO from pending_front_; compacted in place
+    size_t pending_front_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_not_full_;
+    std::condition_variable cv_not_empty_;
+    bool shutdown_;
+
+    IngestionStats stats_;
+};
+
+template<typename T>
+IngestionQueue<T>::IngestionQueue(size_t capacity, BackpressurePolicy policy)
+    : policy_(policy), capacity_(capacity < 1 ? 1 : capacity),
+      buffer_(policy == BackpressurePolicy::CONFLATE ? 0 : capacity_),
+      head_(0), tail_(0), size_(0), pending_front_(0), shutdown_(false), stats_{0, 0, 0} {}
+
+template<typename T>
+bool IngestionQueue<T>::emptyLocked() const {
+    return policy_ == BackpressurePolicy::CONFLATE ? pending_front_ == pending_keys_.size() : size_ == 0;
+}
+
+template<typename T>
+T IngestionQueue<T>::takeLocked() {
+    if (policy_ == BackpressurePolicy::CONFLATE) {
+        uint32_t key = pending_keys_[pending_front_++];
+        if (pending_front_ == pending_keys_.size()) {
+            pending_keys_.clear();   // keeps capacity, so steady state never allocates
+            pending_front_ = 0;
+        } else if (pending_front_ * 2 > pending_keys_.size()) {
+            pending_keys_.erase(pending_keys_.begin(), pending_keys_.begin() + pending_front_);
+            pending_front_ = 0;
+        }
+        pending_[key] = false;
+        return latest_[key];
+    }
+    T item = buffer_[tail_];
+    tail_ = (tail_ + 1) % capacity_;
+    size_--;
+    return item;
+}
+
+template<typename T>
+bool IngestionQueue<T>::pushLocked(const T& item, std::unique_lock<std::mutex>& lock) {
+    switch (policy_) {
+        case BackpressurePolicy::CONFLATE: {
+            uint32_t key = item.driver_id;
+            if (key >= latest_.size()) {
+                // Only grows the first time a key is seen
+                latest_.resize(key + 1);
+                pending_.resize(key + 1, false);
+            }
+            latest_[key] = item;
+            if (pending_[key]) {
+                stats_.conflated++;
+            } else {
+                pending_[key] = true;
+                pending_keys_.push_back(key);
+            }
+            stats_.pushed++;
+            return true;
+        }
+        case BackpressurePolicy::BLOCK:
+            // Wake the consumer first: a batch larger than the free space would otherwise deadlock
+            if (size_ == capacity_) cv_not_empty_.notify_one();
+            cv_not_full_.wait(lock, [this]() { return size_ < capacity_ || shutdown_; });
+            if (shutdown_) return false;
+            break;
+        case BackpressurePolicy::DROP_NEWEST:
+            if (size_ == capacity_) {
+                stats_.dropped++;
+                return false;
+            }
+            break;
+        case BackpressurePolicy::DROP_OLDEST:
+            if (size_ == capacity_) {
+                tail_ = (tail_ + 1) % capacity_;
+                size_--;
+                stats_.dropped++;
+            }
+            break;
+    }
+
+    buffer_[head_] = item;
+    head_ = (head_ + 1) % capacity_;
+    size_++;
+    stats_.pushed++;
+    return true;
+}
+
+template<typename T>
+bool IngestionQueue<T>::push(const T& item) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (shutdown_) return false;
+
+    bool accepted = pushLocked(item, lock);
+
+    lock.unlock();
+    if (accepted) cv_not_empty_.notify_one();
+    return accepted;
+}
+
+template<typename T>
+size_t IngestionQueue<T>::pushBatch(const T* items, size_t count) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (shutdown_) return 0;
+
+    size_t accepted = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (pushLocked(items[i], lock)) {
+            accepted++;
+        } else if (shutdown_) {
+            break;
+        }
+    }
+
+    lock.unlock();
+    if (accepted > 0) cv_not_empty_.notify_one();
+    return accepted;
+}
+
+template<typename T>
+bool IngestionQueue<T>::pop(T& item) {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    cv_not_empty_.wait(lock, [this]() {
+        return !emptyLocked() || shutdown_;
+    });
+
+    if (emptyLocked()) {
+        return false;
+    }
+
+    item = takeLocked();
+
+    lock.unlock();
+    cv_not_full_.notify_one();
+    return true;
+}
+
+template<typename T>
+size_t IngestionQueue<T>::popBatch(T* out, size_t max) {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    cv_not_empty_.wait(lock, [this]() {
+        return !emptyLocked() || shutdown_;
+    });
+
+    size_t popped = 0;
+    while (popped < max && !emptyLocked()) {
+        out[popped++] = takeLocked();
+    }
+
+    lock.unlock();
+    if (popped > 0) cv_not_full_.notify_all();
+    return popped;
+}
+
+template<typename T>
+void IngestionQueue<T>::shutdown() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    shutdown_ = true;
+    cv_not_full_.notify_all();
+    cv_not_empty_.notify_all();
+}
+
+template<typename T>
+IngestionStats IngestionQueue<T>::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
@@ -1,16 +1,35 @@
-#include "ingestion/RingBuffer.h"
+#include "ingestion/BroadcastBus.h"
 #include "telemetry/TelemetryGenerator.h"
+#include "telemetry/TickScheduler.h"
 #include "strategy/StrategyAnalyzer.h"
+#include "strategy/LiveStrategyOptimizer.h"
+#include "strategy/ParameterSweep.h"
+#include "strategy/StrategySurrogate.h"
 #include "data/season_data.h"
 #include "race-control/TrackLimitsMonitor.h"
 #include "race-control/PenaltyEnforcer.h"
+#include "recording/TelemetryRecorder.h"
+#include "recording/ReplaySource.h"
+#include "recording/ArchiveWriter.h"
+#include "recording/ArchiveReader.h"
+#include "analytics/QueryEngine.h"
 #include <thread>
 #include <chrono>
 #include <iostream>
 #include <vector>
 #include <atomic>
+#include <memory>
+#include <mutex>
+#include <map>
 #include <algorithm>
 #include <sstream>
+#include <cstring>
+#include <cstdlib>
+#include <iomanip>
+#include <cmath>
+#include <cstddef>
+#include <fcntl.h>
+#include <unistd.h>
 
 using namespace std;
 
@@ -32,7 +51,478 @@ vector<uint32_t> parseDriverIds(const string& input, size_t max_id){
     return driver_ids;
 }
 
-int main(){
+string formatStops(const vector<uint32_t>& pit_laps){
+    if(pit_laps.empty()) return "No stop";
+    string text = pit_laps.size() == 1 ? "Pit lap" : "Pit laps";
+    for(size_t i = 0; i < pit_laps.size(); i++){
+        text += (i == 0 ? " " : ", ") + to_string(pit_laps[i]);
+    }
+    return text;
+}
+
+struct RunOptions {
+    bool headless = false;          // no prompts, no leaderboard; print classification + stats at the end
+    double speed_multiplier = 1.0;  // 1 = real time (50 Hz); 0 = as fast as the pipeline consumes
+    vector<uint32_t> optimize_ids;  // drivers to run strategy analysis for (headless only)
+    CatchUpPolicy catch_up = CatchUpPolicy::CATCH_UP;
+    uint32_t monte_carlo_trials = 0;  // 0 = skip the randomized evaluation
+    vector<SweepAxis> sweep_axes;     // non-empty = print a what-if table instead of racing
+    bool build_surrogate = false;     // write the "best stop from here" table and exit
+    string record_path;               // non-empty = append every published frame to this log
+    string replay_path;               // non-empty = publish a recorded log instead of simulating
+    uint32_t replay_from_lap = 0;     // with replay_path: start at this lap (0 = the beginning)
+    string archive_path;              // non-empty = compress this recorded log and exit
+    string benchmark_path;            // non-empty = time cold scans of this log and its archive, and exit
+    vector<string> query_paths;       // non-empty = run query over these archives (one per race) and exit
+    Query query;
+};
+
+const char* sweepParameterName(SweepParameter parameter){
+    switch(parameter){
+        case SweepParameter::TIRE_WEAR_FACTOR: return "tire_wear_factor";
+        case SweepParameter::LAP_LENGTH_KM: return "lap_length_km";
+        case SweepParameter::AGGRESSION: return "aggression";
+        case SweepParameter::CONSISTENCY: return "consistency";
+        case SweepParameter::ENGINE_POWER: return "engine_power";
+        case SweepParameter::RELIABILITY: return "reliability";
+    }
+    return "";
+}
+
+// PARAM=V,V,... for track parameters, PARAM:DRIVER=V,V,... for driver/car ones.
+bool parseSweepAxis(const string& spec, size_t driver_count, SweepAxis& axis){
+    const size_t eq = spec.find('=');
+    if(eq == string::npos) return false;
+    string name = spec.substr(0, eq);
+
+    const size_t colon = name.find(':');
+    bool has_driver = colon != string::npos;
+    if(has_driver){
+        vector<uint32_t> ids = parseDriverIds(name.substr(colon + 1), driver_count);
+        if(ids.size() != 1) return false;
+        axis.driver_id = ids[0];
+        name = name.substr(0, colon);
+    } else {
+        axis.driver_id = 0;
+    }
+
+    const SweepParameter all[] = {SweepParameter::TIRE_WEAR_FACTOR, SweepParameter::LAP_LENGTH_KM,
+                                  SweepParameter::AGGRESSION, SweepParameter::CONSISTENCY,
+                                  SweepParameter::ENGINE_POWER, SweepParameter::RELIABILITY};
+    bool found = false;
+    for(SweepParameter parameter : all){
+        if(name == sweepParameterName(parameter)){
+            axis.parameter = parameter;
+            found = true;
+        }
+    }
+    if(!found) return false;
+    const bool track_parameter = axis.parameter == SweepParameter::TIRE_WEAR_FACTOR ||
+                                 axis.parameter == SweepParameter::LAP_LENGTH_KM;
+    if(has_driver == track_parameter) return false;
+
+    stringstream ss(spec.substr(eq + 1));
+    string value;
+    while(getline(ss, value, ',')){
+        char* end = nullptr;
+        float v = strtof(value.c_str(), &end);
+        if(value.empty() || *end != '\0' || v <= 0.0f) return false;
+        axis.values.push_back(v);
+    }
+    return !axis.values.empty();
+}
+
+const char* queryAggregateName(QueryAggregate aggregate){
+    switch(aggregate){
+        case QueryAggregate::COUNT: return "count";
+        case QueryAggregate::MIN: return "min";
+        case QueryAggregate::MAX: return "max";
+        case QueryAggregate::AVG: return "avg";
+        case QueryAggregate::SUM: return "sum";
+        case QueryAggregate::SLOPE: return "slope";
+    }
+    return "";
+}
+
+// count or AGG(COLUMN), comma separated.
+bool parseQuerySelect(const string& spec, vector<QuerySelect>& select){
+    const QueryAggregate all[] = {QueryAggregate::COUNT, QueryAggregate::MIN, QueryAggregate::MAX,
+                                  QueryAggregate::AVG, QueryAggregate::SUM, QueryAggregate::SLOPE};
+    stringstream ss(spec);
+    string item;
+    while(getline(ss, item, ',')){
+        if(item == "count"){
+            select.push_back({QueryAggregate::COUNT, TelemetryArchive::COLUMN_COUNT});
+            continue;
+        }
+        const size_t open = item.find('(');
+        if(open == string::npos || item.back() != ')') return false;
+        const string name = item.substr(0, open);
+        const TelemetryArchive::Column column = TelemetryArchive::columnByName(item.substr(open + 1, item.size() - open - 2));
+        bool found = false;
+        for(QueryAggregate aggregate : all){
+            if(aggregate != QueryAggregate::COUNT && name == queryAggregateName(aggregate)){
+                select.push_back({aggregate, column});
+                found = true;
+            }
+        }
+        if(!found || column == TelemetryArchive::COLUMN_COUNT) return false;
+    }
+    return !select.empty();
+}
+
+// COLUMN<VALUE, COLUMN>=VALUE, ... (also <=, >, = and !=), all of which must hold.
+bool parseQueryWhere(const string& spec, vector<QueryPredicate>& where){
+    const pair<const char*, ScanKernel::Compare> operators[] = {
+        {"<=", ScanKernel::Compare::LESS_EQUAL}, {">=", ScanKernel::Compare::GREATER_EQUAL},
+        {"!=", ScanKernel::Compare::NOT_EQUAL}, {"<", ScanKernel::Compare::LESS},
+        {">", ScanKernel::Compare::GREATER}, {"=", ScanKernel::Compare::EQUAL}};
+    stringstream ss(spec);
+    string item;
+    while(getline(ss, item, ',')){
+        const size_t at = item.find_first_of("<>=!");
+        if(at == string::npos) return false;
+        QueryPredicate predicate;
+        predicate.column = TelemetryArchive::columnByName(item.substr(0, at));
+        size_t length = 0;
+        for(const auto& op : operators){
+            if(item.compare(at, strlen(op.first), op.first) == 0){
+                predicate.op = op.second;
+                length = strlen(op.first);
+                break;
+            }
+        }
+        const string value = item.substr(at + length);
+        char* end = nullptr;
+        predicate.value = strtof(value.c_str(), &end);
+        if(length == 0 || value.empty() || *end != '\0' || predicate.column == TelemetryArchive::COLUMN_COUNT) return false;
+        where.push_back(predicate);
+    }
+    return !where.empty();
+}
+
+// Any of race, driver, lap, stint, comma separated.
+bool parseQueryGroupBy(const string& spec, uint32_t& group_by){
+    stringstream ss(spec);
+    string key;
+    while(getline(ss, key, ',')){
+        if(key == "race") group_by |= GROUP_RACE;
+        else if(key == "driver") group_by |= GROUP_DRIVER;
+        else if(key == "lap") group_by |= GROUP_LAP;
+        else if(key == "stint") group_by |= GROUP_STINT;
+        else return false;
+    }
+    return group_by != 0;
+}
+
+void printUsage(const char* prog){
+    cout << "Usage: " << prog << " [--headless] [--speed=1|10|...|max] [--optimize=ID,ID,...]"
+         << " [--on-late=catch-up|skip] [--monte-carlo=MAX_TRIALS]"
+         << " [--sweep=PARAM[:ID]=V,V,...]... [--build-surrogate] [--record=PATH]"
+         << " [--replay=PATH [--from-lap=N]] [--archive=PATH] [--benchmark-archive=PATH]"
+         << " [--query=ARCHIVE,... [--select=AGG(COL),...] [--where=COL<V,...] [--group-by=KEY,...]]\n"
+         << "Sweep parameters: tire_wear_factor, lap_length_km (track);"
+         << " aggression, consistency, engine_power, reliability (per driver, :ID required)\n"
+         << "Query: AGG is count, min, max, avg, sum or slope (change per lap); COL a measurement"
+         << " (speed, throttle, brake, tire_wear, tire_temp_fl|fr|rl|rr), or in --where also driver_id,"
+         << " lap, sector, race_position; KEY is race, driver, lap or stint\n";
+}
+
+// Returns false on an unknown or malformed flag.
+bool parseRunOptions(int argc, char* argv[], size_t driver_count, RunOptions& options){
+    for(int i = 1; i < argc; i++){
+        const char* arg = argv[i];
+        if(strcmp(arg, "--headless") == 0){
+            options.headless = true;
+        } else if(strncmp(arg, "--speed=", 8) == 0){
+            const char* value = arg + 8;
+            if(strcmp(value, "max") == 0){
+                options.speed_multiplier = 0.0;
+            } else {
+                char* end = nullptr;
+                double multiplier = strtod(value, &end);
+                if(end == value || *end != '\0' || multiplier <= 0.0) return false;
+                options.speed_multiplier = multiplier;
+            }
+        } else if(strncmp(arg, "--optimize=", 11) == 0){
+            options.optimize_ids = parseDriverIds(arg + 11, driver_count);
+        } else if(strcmp(arg, "--on-late=catch-up") == 0){
+            options.catch_up = CatchUpPolicy::CATCH_UP;
+        } else if(strcmp(arg, "--on-late=skip") == 0){
+            options.catch_up = CatchUpPolicy::SKIP;
+        } else if(strncmp(arg, "--monte-carlo=", 14) == 0){
+            char* end = nullptr;
+            unsigned long trials = strtoul(arg + 14, &end, 10);
+            if(end == arg + 14 || *end != '\0' || trials < 2) return false;
+            options.monte_carlo_trials = static_cast<uint32_t>(trials);
+        } else if(strcmp(arg, "--build-surrogate") == 0){
+            options.build_surrogate = true;
+        } else if(strncmp(arg, "--record=", 9) == 0){
+            options.record_path = arg + 9;
+            if(options.record_path.empty()) return false;
+        } else if(strncmp(arg, "--replay=", 9) == 0){
+            options.replay_path = arg + 9;
+            if(options.replay_path.empty()) return false;
+        } else if(strncmp(arg, "--archive=", 10) == 0){
+            options.archive_path = arg + 10;
+            if(options.archive_path.empty()) return false;
+        } else if(strncmp(arg, "--benchmark-archive=", 20) == 0){
+            options.benchmark_path = arg + 20;
+            if(options.benchmark_path.empty()) return false;
+        } else if(strncmp(arg, "--query=", 8) == 0){
+            stringstream ss(arg + 8);
+            string path;
+            while(getline(ss, path, ',')){
+                if(path.empty()) return false;
+                options.query_paths.push_back(path);
+            }
+            if(options.query_paths.empty()) return false;
+        } else if(strncmp(arg, "--select=", 9) == 0){
+            if(!parseQuerySelect(arg + 9, options.query.select)) return false;
+        } else if(strncmp(arg, "--where=", 8) == 0){
+            if(!parseQueryWhere(arg + 8, options.query.where)) return false;
+        } else if(strncmp(arg, "--group-by=", 11) == 0){
+            if(!parseQueryGroupBy(arg + 11, options.query.group_by)) return false;
+        } else if(strncmp(arg, "--from-lap=", 11) == 0){
+            char* end = nullptr;
+            unsigned long lap = strtoul(arg + 11, &end, 10);
+            if(end == arg + 11 || *end != '\0' || lap == 0) return false;
+            options.replay_from_lap = static_cast<uint32_t>(lap);
+        } else if(strncmp(arg, "--sweep=", 8) == 0){
+            SweepAxis axis;
+            if(!parseSweepAxis(arg + 8, driver_count, axis)) return false;
+            options.sweep_axes.push_back(axis);
+        } else {
+            return false;
+        }
+    }
+    if(options.query_paths.empty()){
+        if(!options.query.select.empty() || !options.query.where.empty() || options.query.group_by != 0) return false;
+    } else if(options.query.select.empty()){
+        options.query.select.push_back({QueryAggregate::COUNT, TelemetryArchive::COLUMN_COUNT});
+    }
+    // A replayed race is already decided: nothing to plan, and nowhere to seek without a log
+    if(options.replay_path.empty()) return options.replay_from_lap == 0;
+    return options.optimize_ids.empty();
+}
+
+// Drops a file from the page cache so the next read of it comes from disk. Dirty
+// pages can't be dropped, so anything just written is flushed first. False where
+// the platform has no way to ask (no POSIX_FADV_DONTNEED, e.g. macOS).
+bool evictFromPageCache(const string& path){
+#ifdef POSIX_FADV_DONTNEED
+    int fd = open(path.c_str(), O_RDONLY);
+    if(fd < 0) return false;
+    fdatasync(fd);
+    const bool evicted = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+    close(fd);
+    return evicted;
+#else
+    (void)path;
+    return false;
+#endif
+}
+
+// Compresses a --record log into TelemetryArchive::archivePath(log) and checks every
+// frame round-trips.
+int archiveRecording(const string& log_path){
+    ReplaySource log(log_path);
+    if(!log.isOpen()) {
+        cerr << "Could not read " << log_path << ": not a telemetry log\n";
+        return 1;
+    }
+
+    const string archive_path = TelemetryArchive::archivePath(log_path);
+    const auto encode_start = chrono::steady_clock::now();
+    ArchiveWriter writer(archive_path, log.driverCount());
+    const TelemetryFrame* tick;
+    size_t tick_size;
+    while(log.nextTick(tick, tick_size)) writer.append(tick, tick_size);
+    if(!writer.finish()) {
+        cerr << "Could not write " << archive_path << "\n";
+        return 1;
+    }
+    const double encode_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - encode_start).count();
+
+    const ArchiveWriter::Stats stats = writer.stats();
+    const double frames = max<double>(stats.frames, 1);
+    cout << "Wrote " << archive_path << ": " << stats.frames << " frames in " << stats.chunks << " chunks, "
+         << fixed << setprecision(2) << stats.raw_bytes / (1024.0 * 1024.0) << " MB -> "
+         << stats.archive_bytes / (1024.0 * 1024.0) << " MB (" << setprecision(1)
+         << static_cast<double>(stats.raw_bytes) / max<uint64_t>(stats.archive_bytes, 1) << "x), encoded in "
+         << encode_ms << " ms\n";
+    cout << "Bytes per frame:";
+    for(uint32_t c = 0; c < TelemetryArchive::COLUMN_COUNT; c++) {
+        cout << (c % 5 == 0 ? "\n  " : "  ") << TelemetryArchive::columnName(static_cast<TelemetryArchive::Column>(c))
+             << " " << setprecision(2)
+             << stats.column_bytes[c] / frames;
+    }
+    cout << "\n";
+
+    // Every field of every frame must come back in publish order
+    ArchiveReader archive(archive_path);
+    FrameColumns columns;
+    vector<TelemetryFrame> decoded;
+    const size_t compared_bytes = offsetof(TelemetryFrame, sector) + sizeof(uint8_t);   // not the padding
+    uint64_t compared = 0;
+    uint64_t mismatches = 0;
+    log.rewind();
+    tick_size = 0;
+    size_t in_tick = 0;
+    // Next log frame to compare against; false once the log runs out
+    auto nextLogFrame = [&]() {
+        while(in_tick == tick_size) {
+            in_tick = 0;
+            if(!log.nextTick(tick, tick_size)) return false;
+        }
+        return true;
+    };
+    bool log_short = false;
+    while(!log_short && archive.next(columns)) {
+        columns.toFrames(decoded);
+        for(const TelemetryFrame& frame : decoded) {
+            if(!nextLogFrame()) {
+                log_short = true;
+                break;
+            }
+            if(memcmp(&frame, &tick[in_tick++], compared_bytes) != 0) mismatches++;
+            compared++;
+        }
+    }
+    // A decode that stops early (a corrupt chunk) must not pass as a shorter match
+    const bool log_drained = !log_short && !nextLogFrame();
+    if(!archive.isOpen() || mismatches > 0 || !log_drained || compared != log.frameCount() ||
+       archive.frameCount() != log.frameCount()) {
+        cerr << "Round trip failed: " << compared << " of " << log.frameCount() << " frames compared ("
+             << archive.frameCount() << " in the archive), " << mismatches << " differ\n";
+        return 1;
+    }
+
+    cout << "Round trip: all " << compared << " frames identical\n";
+    return 0;
+}
+
+// Times scanning a --record log and its --archive output from a cold page cache: raw
+// frames are only read, the archive is also decoded.
+int benchmarkArchive(const string& log_path){
+    const string archive_path = TelemetryArchive::archivePath(log_path);
+    ArchiveReader archive(archive_path);
+    if(!archive.isOpen()) {
+        cerr << "Could not read " << archive_path << ": run --archive=" << log_path << " first\n";
+        return 1;
+    }
+    const double raw_frame_bytes = static_cast<double>(archive.frameCount()) * sizeof(TelemetryFrame);
+
+    bool cold = evictFromPageCache(log_path);
+    vector<char> buffer(1 << 20);
+    uint64_t raw_bytes = 0;
+    const auto raw_start = chrono::steady_clock::now();
+    int fd = open(log_path.c_str(), O_RDONLY);
+    if(fd < 0) {
+        cerr << "Could not read " << log_path << "\n";
+        return 1;
+    }
+    ssize_t n;
+    while((n = read(fd, buffer.data(), buffer.size())) > 0) raw_bytes += static_cast<uint64_t>(n);
+    close(fd);
+    const double raw_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - raw_start).count();
+
+    // Whole frames, then the three columns a typical per-lap query reads
+    FrameColumns columns;
+    auto scanArchive = [&](uint32_t column_mask, double& ms) {
+        cold = evictFromPageCache(archive_path) && cold;
+        const auto start = chrono::steady_clock::now();
+        ArchiveReader reader(archive_path);
+        uint64_t count = 0;
+        while(reader.next(columns, column_mask)) count += columns.size();
+        ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        return count;
+    };
+    double decode_ms = 0.0;
+    double projected_ms = 0.0;
+    const uint64_t decoded_frames = scanArchive(TelemetryArchive::ALL_COLUMNS, decode_ms);
+    scanArchive(TelemetryArchive::columnBit(TelemetryArchive::DRIVER_ID) |
+                TelemetryArchive::columnBit(TelemetryArchive::LAP) |
+                TelemetryArchive::columnBit(TelemetryArchive::SPEED), projected_ms);
+
+    cout << (cold ? "Cold scan" : "Warm scan (the page cache can't be dropped here)") << ": raw log read in "
+         << fixed << setprecision(2) << raw_ms << " ms ("
+         << setprecision(1) << raw_bytes / max(raw_ms, 1e-3) / 1e6 << " GB/s); archive read and decoded in "
+         << setprecision(2) << decode_ms << " ms (" << setprecision(0)
+         << decoded_frames / max(decode_ms, 1e-3) / 1000.0 << " M frames/s, "
+         << setprecision(1) << raw_frame_bytes / max(decode_ms, 1e-3) / 1e6 << " GB/s of raw frames), driver_id/lap/speed only in "
+         << setprecision(2) << projected_ms << " ms\n";
+    return 0;
+}
+
+// Runs options.query over the archives in options.query_paths and prints one line per group.
+int runQuery(const RunOptions& options, const vector<DriverProfile>& drivers){
+    vector<unique_ptr<ArchiveReader>> archives;
+    vector<const ArchiveReader*> races;
+    uint64_t frames = 0;
+    for(const string& path : options.query_paths){
+        archives.push_back(make_unique<ArchiveReader>(path));
+        if(!archives.back()->isOpen()){
+            cerr << "Could not read " << path << ": not a telemetry archive (see --archive)\n";
+            return 1;
+        }
+        races.push_back(archives.back().get());
+        frames += archives.back()->frameCount();
+    }
+
+    const Query& query = options.query;
+    QueryEngine engine;
+    vector<QueryRow> rows;
+    const auto start = chrono::steady_clock::now();
+    if(!engine.run(query, races, rows)){
+        cerr << "Query failed: unsupported column for that operation, or a corrupt archive\n";
+        return 1;
+    }
+    const double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    const bool by_race = (query.group_by & GROUP_RACE) != 0;
+    const bool by_driver = (query.group_by & GROUP_DRIVER) != 0;
+    const bool by_lap = (query.group_by & GROUP_LAP) != 0;
+    const bool by_stint = (query.group_by & GROUP_STINT) != 0;
+    if(by_race) cout << setw(6) << "race";
+    if(by_driver) cout << setw(20) << "driver";
+    if(by_lap) cout << setw(5) << "lap";
+    if(by_stint) cout << setw(7) << "stint";
+    vector<int> widths;
+    for(const QuerySelect& select : query.select){
+        string name = queryAggregateName(select.aggregate);
+        if(select.aggregate != QueryAggregate::COUNT) name += string("(") + TelemetryArchive::columnName(select.column) + ")";
+        widths.push_back(max<int>(static_cast<int>(name.size()), 10) + 2);
+        cout << setw(widths.back()) << name;
+    }
+    cout << "\n";
+
+    for(const QueryRow& row : rows){
+        if(by_race) cout << setw(6) << row.race;
+        if(by_driver) cout << setw(20) << (row.driver_id < drivers.size() ? drivers[row.driver_id].driver_id : to_string(row.driver_id));
+        if(by_lap) cout << setw(5) << row.lap;
+        if(by_stint) cout << setw(7) << row.stint;
+        for(size_t s = 0; s < query.select.size(); s++){
+            const QueryAggregate aggregate = query.select[s].aggregate;
+            const int width = widths[s];
+            const double value = row.values[s];
+            if(std::isnan(value)) cout << setw(width) << "-";
+            else if(aggregate == QueryAggregate::COUNT) cout << setw(width) << static_cast<uint64_t>(value);
+            else cout << setw(width) << fixed << setprecision(aggregate == QueryAggregate::SLOPE ? 5 : 3) << value;
+        }
+        cout << "\n";
+    }
+
+    const QueryEngine::Stats stats = engine.stats();
+    cout << rows.size() << " groups from " << stats.rows_matched << " of " << frames << " frames in "
+         << races.size() << (races.size() == 1 ? " race" : " races") << "; " << stats.chunks_scanned
+         << " chunks scanned, " << stats.chunks_skipped << " skipped; " << fixed << setprecision(1) << ms
+         << " ms (" << ScanKernel::activeIsa() << ", " << WorkStealingPool::shared().threadCount() << " threads)\n";
+    return 0;
+}
+
+int main(int argc, char* argv[]){
+    const auto launch_time = chrono::steady_clock::now();
 
     atomic<bool> done(false);
 
@@ -52,93 +542,381 @@ int main(){
 
     uint32_t total_laps = 52;
 
-    // Ask user about strategy optimization
-    cout << "\nRun strategy analysis? (y/n): ";
-    string response;
-    getline(cin, response);
+    RunOptions options;
+    if(!parseRunOptions(argc, argv, drivers.size(), options)) {
+        printUsage(argv[0]);
+        return 1;
+    }
 
-    map<uint32_t, uint32_t> optimal_strategies;
+    if(!options.archive_path.empty()) return archiveRecording(options.archive_path);
+    if(!options.benchmark_path.empty()) return benchmarkArchive(options.benchmark_path);
+    if(!options.query_paths.empty()) return runQuery(options, drivers);
 
-    if (response == "y" || response == "Y") {
-        // Display driver list
-        cout << "\nAvailable drivers:\n";
+    if(options.build_surrogate) {
+        auto model = RaceModel::create(track, drivers, cars, total_laps);
+        const RaceSimulator simulator(model);
+
+        // The table is built from the event model: first check it against the 20 ms tick
+        // model for every driver and stop lap, all of a driver's stops run as kernel lanes.
+        vector<uint32_t> all_stops;
+        for(uint32_t lap = 1; lap <= total_laps; lap++) all_stops.push_back(lap);
+        float worst_model_gap = 0.0f;
         for(uint32_t i = 0; i < drivers.size(); i++) {
-            cout << i << ": " << drivers[i].driver_id << "\n";
+            const vector<float> events = simulator.simulatePitCandidates(i, all_stops);
+            const vector<float> ticks = simulator.simulateRaceTicksCandidates(i, all_stops);
+            for(size_t c = 0; c < all_stops.size(); c++) {
+                worst_model_gap = max(worst_model_gap, fabs(events[c] - ticks[c]));
+            }
+        }
+        cout << "Event model vs. tick model: " << fixed << setprecision(4) << worst_model_gap << " s over "
+             << drivers.size() * all_stops.size() << " races\n";
+        if(worst_model_gap > RaceSimulator::EVENT_TOLERANCE_SECONDS) {
+            cerr << "Event model is outside its " << RaceSimulator::EVENT_TOLERANCE_SECONDS
+                 << " s tolerance; not building the surrogate\n";
+            return 1;
+        }
+
+        StrategySurrogate::BuildReport report;
+        if(!StrategySurrogate::build(*model, StrategySurrogate::DEFAULT_PATH, &report)) {
+            cerr << "Could not write " << StrategySurrogate::DEFAULT_PATH << "\n";
+            return 1;
+        }
+        cout << "Wrote " << StrategySurrogate::DEFAULT_PATH << ": " << report.table_bytes / 1024 << " KB, "
+             << report.validation_points << " validation points\n";
+
+        // Spot-check every driver against the full simulator, from the start and from
+        // part-worn tires later in the race. From lap L the candidates are a stop on laps
+        // L+1 .. total_laps-1 and, as "stopping" on the last lap, running to the flag.
+        StrategySurrogate surrogate(model);
+        float worst_error = 0.0f;
+        float worst_bound = 0.0f;
+        double query_us = 0.0;
+        size_t queries = 0;
+        for(uint32_t quarter = 4; quarter >= 1; quarter--) {
+            const uint32_t remaining = total_laps * quarter / 4;
+            const uint32_t lap = total_laps - remaining;
+            vector<uint32_t> laps;
+            for(uint32_t pit_lap = lap + 1; pit_lap <= total_laps; pit_lap++) laps.push_back(pit_lap);
+
+            for(float wear : {0.0f, 0.25f, 0.5f, 0.75f}) {
+                for(uint32_t i = 0; i < drivers.size(); i++) {
+                    SurrogateAnswer answer;
+                    const auto query_start = chrono::steady_clock::now();
+                    if(!surrogate.bestStop(i, remaining, wear, answer)) continue;
+                    query_us += chrono::duration<double, micro>(chrono::steady_clock::now() - query_start).count();
+                    queries++;
+
+                    const RaceSimulator::DriverSnapshot from{lap, 1, 0.0, wear, 0.0, false};
+                    const vector<float> times = simulator.simulatePitCandidates(i, from, laps);
+                    const float exact = *min_element(times.begin(), times.end());
+                    worst_error = max(worst_error, fabs(answer.finish_seconds - exact));
+                    worst_bound = max(worst_bound, answer.error_seconds);
+                }
+            }
+        }
+        cout << "Best-stop error vs. simulator over " << queries << " states: " << fixed << setprecision(4)
+             << worst_error << " s (bound " << worst_bound << " s), " << setprecision(2)
+             << (queries > 0 ? query_us / queries : 0.0) << " us per query\n";
+        return 0;
+    }
+
+    if(!options.sweep_axes.empty()) {
+        // What-if table for the --optimize drivers (everyone if none given); no race
+        vector<uint32_t> sweep_ids = options.optimize_ids;
+        if(sweep_ids.empty()) {
+            for(uint32_t i = 0; i < drivers.size(); i++) sweep_ids.push_back(i);
+        }
+
+        const auto sweep_start = chrono::steady_clock::now();
+        auto model = RaceModel::create(track, drivers, cars, total_laps);
+        ParameterSweep sweep(model);
+        const SweepTable table = sweep.run(options.sweep_axes, sweep_ids);
+        const double sweep_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - sweep_start).count();
+
+        for(size_t point = 0; point < table.points; point++) {
+            cout << "\n";
+            for(size_t a = 0; a < table.axes.size(); a++) {
+                const SweepAxis& axis = table.axes[a];
+                cout << (a == 0 ? "" : ", ") << sweepParameterName(axis.parameter);
+                if(axis.parameter != SweepParameter::TIRE_WEAR_FACTOR && axis.parameter != SweepParameter::LAP_LENGTH_KM) {
+                    cout << "[" << model->driverName(axis.driver_id) << "]";
+                }
+                cout << "=" << table.value(point, a);
+            }
+            cout << ":\n";
+            for(size_t d = 0; d < sweep_ids.size(); d++) {
+                const SweepRow& row = table.row(point, d);
+                cout << "  " << model->driverName(row.driver_id) << ": Pit lap " << row.optimal_pit_lap
+                     << " (finish time: " << (row.finish_time_seconds / 60.0f) << " min)\n";
+            }
+        }
+        cout << "\n" << table.points << " grid points x " << sweep_ids.size() << " drivers: "
+             << table.unique_evaluations << " distinct simulations in " << fixed << setprecision(3)
+             << sweep_ms << " ms\n";
+        return 0;
+    }
+
+    // Frames come from the log as recorded; the generator below is never stepped
+    unique_ptr<ReplaySource> replay;
+    if(!options.replay_path.empty()) {
+        replay.reset(new ReplaySource(options.replay_path));
+        if(!replay->isOpen() || replay->driverCount() != drivers.size()) {
+            cerr << "Could not replay " << options.replay_path << ": not a telemetry log for this field\n";
+            return 1;
+        }
+        if(options.replay_from_lap > 0 && !replay->seekToLap(options.replay_from_lap)) {
+            cerr << "Could not seek to lap " << options.replay_from_lap << " in " << options.replay_path << "\n";
+            return 1;
+        }
+    }
+
+    // Ask user about strategy optimization (headless runs take the list from --optimize)
+    string response = "n";
+    if(options.headless) {
+        if(!options.optimize_ids.empty()) response = "y";
+    } else if(!replay) {
+        cout << "\nRun strategy analysis? (y/n): ";
+        getline(cin, response);
+    }
+
+    vector<uint32_t> driver_ids;
+    if (response == "y" || response == "Y") {
+        driver_ids = options.optimize_ids;
+
+        if(!options.headless) {
+            // Display driver list
+            cout << "\nAvailable drivers:\n";
+            for(uint32_t i = 0; i < drivers.size(); i++) {
+                cout << i << ": " << drivers[i].driver_id << "\n";
+            }
+            
+            cout << "\nEnter driver IDs to optimize (comma-separated, no spaces): ";
+            string input;
+            getline(cin, input);
+            
+            driver_ids = parseDriverIds(input, drivers.size());
         }
-        
-        cout << "\nEnter driver IDs to optimize (comma-separated, no spaces): ";
-        string input;
-        getline(cin, input);
-        
-        vector<uint32_t> driver_ids = parseDriverIds(input, drivers.size());
         
         if(driver_ids.empty()) {
             cout << "No valid driver IDs entered. Skipping strategy analysis.\n";
-        } else {
-        
-        cout << "\nAnalyzing strategies (this may take 10-30 seconds)...\n";
-        
-        // Run strategy analyzer
-        StrategyAnalyzer analyzer(track, drivers, cars, total_laps);
-        vector<StrategyResult> results = analyzer.analyzeStrategies(driver_ids);
-        
-        // Display results
-        cout << "\nStrategy Analysis Results:\n";
-        cout << "==========================\n";
-        for(const auto& result : results) {
-            cout << drivers[result.driver_id].driver_id 
-                << ": Pit lap " << result.optimal_pit_lap 
-                << " (finish time: " << (result.finish_time_seconds / 60.0f) << " min)\n";
-            
-            // Store for use in live race
-            optimal_strategies[result.driver_id] = result.optimal_pit_lap;
         }
-        cout << "\n";
-        } // end else block for non-empty driver_ids
     }
 
-    auto penalty_enforcer = std::make_shared<PenaltyEnforcer>(drivers);
+    // One immutable copy of the race inputs, shared by everything below
+    auto model = RaceModel::create(track, drivers, cars, total_laps);
+    auto penalty_enforcer = std::make_shared<PenaltyEnforcer>(*model);
 
-    RingBuffer<TelemetryFrame> buffer(1024);
-    TelemetryGenerator generator(track, drivers, cars, total_laps, penalty_enforcer);
-    TrackLimitsMonitor track_limits_monitor(track, drivers, penalty_enforcer);
+    // Each frame is published once; every stage reads it on its own thread through its own
+    // cursor, and a stage that falls behind (usually the terminal) is lapped rather than
+    // holding up race control.
+    BroadcastBus<TelemetryFrame> bus(4096);
+    TelemetryGenerator generator(model, penalty_enforcer);
+    TrackLimitsMonitor track_limits_monitor(model, penalty_enforcer);
 
-    if(!optimal_strategies.empty()) {
-        generator.setOptimalStrategies(optimal_strategies);
+    // Not waited on by the producer: if the disk can't keep up the recorder is lapped
+    // and reports the gap, the race itself never slows down.
+    // Opened before any analysis thread starts, so failing here has nothing to join.
+    unique_ptr<TelemetryRecorder> recorder;
+    if(!options.record_path.empty()) {
+        recorder.reset(new TelemetryRecorder(options.record_path, bus, drivers.size()));
+        if(!recorder->isOpen()) {
+            cerr << "Could not create " << options.record_path << "\n";
+            return 1;
+        }
     }
 
-    // Print strategies that will be used, then start the race
+    // 20 ms of simulated time per tick; the wall-clock period shrinks with --speed, and
+    // --speed=max drops pacing entirely.
+    const bool max_speed = options.speed_multiplier == 0.0;
+    // Unpaced and unwatched, a race outruns the analysis and race control, so which plan a
+    // driver got and when a penalty landed would depend on thread timing. There the plan
+    // is settled before the start, each re-plan is applied on the lap it was made for and
+    // race control finishes each tick before the next is generated.
+    const bool plans_in_lockstep = options.headless && max_speed;
+
+    // Strategy analysis otherwise runs alongside the race: everyone starts on wear-based
+    // pitting and each driver's planned stop is handed to the generator as soon as it is
+    // computed (coarse grid first, then refined).
+    // The cache file is only touched when there is analysis to memoize
+    unique_ptr<StrategyCache> cache;
+    if(!driver_ids.empty()) cache = make_unique<StrategyCache>();
+    StrategyAnalyzer analyzer(model, WorkStealingPool::shared(), cache.get());
+    mutex strategy_mutex;
+    map<uint32_t, uint32_t> optimal_strategies;
+    map<uint32_t, float> planned_finish_times;
+    vector<StopPlan> multi_stop_plans;
+    vector<MonteCarloResult> monte_carlo_results;
+
+    auto publishPlan = [&](const StrategyResult& result) {
+        lock_guard<mutex> lock(strategy_mutex);
+        optimal_strategies[result.driver_id] = result.optimal_pit_lap;
+        planned_finish_times[result.driver_id] = result.finish_time_seconds;
+        generator.setOptimalStrategies(optimal_strategies);
+    };
+    if(plans_in_lockstep && !driver_ids.empty()) analyzer.analyzeProgressive(driver_ids, publishPlan);
+
+    // What the strategist is working on, for the leaderboard: the phase (null once
+    // idle) and its (jobs finished, jobs total).
+    atomic<const char*> analysis_phase(nullptr);
+    atomic<size_t> analysis_done(0);
+    atomic<size_t> analysis_total(0);
+    auto progressOf = [&](const char* phase) -> StrategyProgress {
+        return [&, phase](size_t done, size_t total) {
+            analysis_done.store(done, memory_order_relaxed);
+            analysis_total.store(total, memory_order_relaxed);
+            analysis_phase.store(phase, memory_order_release);
+        };
+    };
+
+    thread strategist;
+    if(!driver_ids.empty()) strategist = thread([&]() {
+        if(!plans_in_lockstep) analyzer.analyzeProgressive(driver_ids, publishPlan, progressOf("pit stop search"));
+
+        // Advisory reports, printed after the race: the live race executes one planned stop
+        multi_stop_plans = analyzer.analyzeMultiStop(driver_ids, MultiStopOptimizer::DEFAULT_MAX_STOPS,
+                                                     progressOf("multi-stop plans"));
+        if(options.monte_carlo_trials > 0) {
+            MonteCarloOptions mc;
+            mc.max_trials = options.monte_carlo_trials;
+            mc.min_trials = min(mc.min_trials, mc.max_trials);
+            monte_carlo_results = analyzer.analyzeMonteCarlo(driver_ids, mc, progressOf("Monte Carlo"));
+        }
+        analysis_phase.store(nullptr, memory_order_release);
+    });
+
+    // Once racing, re-plan the remaining race from the live state each time the leader
+    // starts a lap, within LiveStrategyOptimizer's latency budget, and swap in any change.
+    // In lockstep the producer re-plans inline and every driver is always reached.
+    const RaceSimulator live_simulator(model);
+    const LiveStrategyOptimizer live_optimizer(live_simulator,
+        plans_in_lockstep ? chrono::microseconds(chrono::hours(1)) : LiveStrategyOptimizer::DEFAULT_BUDGET);
+    uint64_t replans = 0;
+    uint64_t replans_changed = 0;
+    double worst_replan_ms = 0.0;
+    uint64_t last_snapshot_ns = UINT64_MAX;
+
+    // False if there was no new snapshot to plan from
+    auto replanFromSnapshot = [&]() {
+        auto snapshot = generator.latestSnapshot();
+        if(!snapshot || snapshot->timestamp_ns == last_snapshot_ns) return false;
+        last_snapshot_ns = snapshot->timestamp_ns;
+
+        map<uint32_t, uint32_t> plan;
+        {
+            lock_guard<mutex> lock(strategy_mutex);
+            plan = optimal_strategies;
+        }
+        if(plan.empty()) return true;
+
+        ReplanReport report = live_optimizer.reoptimize(*snapshot, plan);
+        replans++;
+        worst_replan_ms = max(worst_replan_ms, report.elapsed_ms);
+
+        lock_guard<mutex> lock(strategy_mutex);
+        bool changed = false;
+        for(const auto& replan : report.plans) {
+            auto it = optimal_strategies.find(replan.driver_id);
+            if(it != optimal_strategies.end() && it->second != replan.pit_lap) {
+                it->second = replan.pit_lap;
+                changed = true;
+                replans_changed++;
+            }
+        }
+        if(changed) generator.setOptimalStrategies(optimal_strategies);
+        return true;
+    };
+
+    thread replanner;
+    if(!driver_ids.empty() && !plans_in_lockstep) replanner = thread([&]() {
+        while(!done.load()) {
+            if(!replanFromSnapshot()) this_thread::sleep_for(chrono::milliseconds(2));
+        }
+    });
+
     cout << "\nRace strategies:\n";
     cout << "================\n";
-    for (uint32_t i = 0; i < drivers.size(); i++) {
-        cout << drivers[i].driver_id << ": ";
-        auto it = optimal_strategies.find(i);
-        if (it != optimal_strategies.end()) {
-            cout << "Optimal pit lap " << it->second << "\n";
-        } else {
-            cout << "Wear-based pitting\n";
+    if(driver_ids.empty()) {
+        cout << "Wear-based pitting for all drivers\n";
+    } else if(plans_in_lockstep) {
+        for(const auto& entry : optimal_strategies) {
+            cout << model->driverName(entry.first) << ": pit on lap " << entry.second << "\n";
+        }
+    } else {
+        cout << "Wear-based pitting until analysis publishes a plan for:";
+        for(size_t i = 0; i < driver_ids.size(); i++) {
+            cout << (i == 0 ? " " : ", ") << model->driverName(driver_ids[i]);
         }
+        cout << "\n";
     }
-    cout << "\nPress Enter to start race...\n";
-    cout.flush();
-    {
+    if(!options.headless) {
+        cout << "\nPress Enter to start race...\n";
+        cout.flush();
         string start;
         getline(cin, start);
     }
     cout << "\nStarting race...\n\n";
+    cout.flush();
+
+    // Unpaced, the producer waits on race control every few ticks, so it polls for the
+    // next tick before sleeping; paced ticks are 20 ms apart and a spin can't catch one.
+    auto race_control_feed = bus.subscribe(max_speed ? WaitStrategy::SPIN_THEN_PARK : WaitStrategy::PARK);
+    // Frames race control has finished with, which consumed() runs ahead of
+    atomic<uint64_t> race_control_applied(race_control_feed.consumed());
+    auto render_feed = bus.subscribe();
+
+    const auto tick_period = chrono::duration_cast<chrono::nanoseconds>(
+        chrono::duration<double, milli>(max_speed ? 20.0 : 20.0 / options.speed_multiplier));
+    TickScheduler scheduler(tick_period, options.catch_up);
+
+    vector<TelemetryFrame> final_frames;
+    uint64_t ticks = 0;
+    uint64_t overtakes = 0;
+    const auto race_start = chrono::steady_clock::now();
+    chrono::steady_clock::time_point first_frame_time;
 
     thread producer([&]() {
+        // Reused every tick so the steady-state producer loop never touches the heap
+        FrameBatch batch;
+        vector<TelemetryFrame> frames;
+        frames.reserve(drivers.size());
+        // A replayed tick is published straight out of the log mapping
+        const TelemetryFrame* tick = nullptr;
+        size_t tick_size = 0;
+        scheduler.start();
+
         while(!done.load()){
-            auto frames = generator.next();
+            bool finished;
+            if(replay) {
+                // The finishing tick is never published, so a log ends one tick
+                // early; its last tick stands in for the classification.
+                finished = !replay->nextTick(tick, tick_size);
+                if(finished) {
+                    frames.assign(tick, tick + tick_size);
+                } else {
+                    ticks++;
+                }
+            } else {
+                generator.nextInto(batch);
+                if(plans_in_lockstep && !driver_ids.empty()) replanFromSnapshot();
+                batch.toFrames(frames);
+                ticks++;
+                overtakes += generator.lastOvertakes().size();
+                finished = generator.isRaceFinished();
+                tick = frames.data();
+                tick_size = frames.size();
+            }
 
-            if(generator.isRaceFinished()) {
+            if(finished) {
                 done.store(true);
-                buffer.shutdown();
+                bus.shutdown();
+                // Watching live, nobody should wait past the flag for the advisory reports;
+                // a headless run exists to print them, so it lets them finish.
+                if(!options.headless) analyzer.cancel();
                 
                 string winner = "";
                 for(const auto& frame : frames) {
                     if(frame.race_position == 1) {
-                        winner = drivers[frame.driver_id].driver_id;
+                        winner = model->driverName(frame.driver_id);
                         break;
                     }
                 }
@@ -146,22 +924,40 @@ int main(){
                 cout << "\n🏁 RACE FINISHED! 🏁\n";
                 cout << "🏆 Winner: " << winner << " 🏆\n";
 
+                final_frames = frames;
                 break;
             }
 
-            for(const auto &frame : frames){
-                if(!buffer.push(frame)){
-                    TelemetryFrame old_frame;
-                    buffer.pop(old_frame);
-                    cout << "[Telemetry] Buffer full, dropping frame " << drivers[old_frame.driver_id].driver_id << "\n";
-                    buffer.push(frame);
+            // Publish the whole tick at once; never waits on subscribers.
+            bus.publishBatch(tick, tick_size);
+            if(ticks == 1) first_frame_time = chrono::steady_clock::now();
+
+            if(max_speed) {
+                // Unpaced: run as fast as race control keeps up, but never lap it. In
+                // lockstep a penalty must land on the tick it was earned.
+                const uint64_t max_lag = plans_in_lockstep ? 0 : bus.capacity() / 2;
+                while(bus.published() - race_control_applied.load(memory_order_acquire) > max_lag) {
+                    this_thread::yield();
                 }
+            } else {
+                scheduler.waitNextTick();
             }
-            this_thread::sleep_for(chrono::milliseconds(20));
         }
     });
 
-    thread consumer([&]() {
+    // Race control consumes every frame on its own thread so penalty enforcement never
+    // waits for a terminal redraw.
+    thread race_control([&]() {
+        vector<TelemetryFrame> batch(drivers.size());
+        size_t count;
+        while((count = race_control_feed.next(batch.data(), batch.size())) > 0) {
+            track_limits_monitor.processFrames(batch.data(), count);
+            race_control_applied.store(race_control_feed.consumed(), memory_order_release);
+        }
+    });
+
+    thread renderer;
+    if(!options.headless) renderer = thread([&]() {
         vector<TelemetryFrame> latestFrames(drivers.size());
         // Initialize with valid positions to avoid sorting issues on first frames
         for(size_t i = 0; i < latestFrames.size(); i++) {
@@ -171,21 +967,25 @@ int main(){
             latestFrames[i].sector = 1;
         }
         
-        while(!done.load()){
-            TelemetryFrame frame;
+        // Drain up to a full tick per wakeup
+        vector<TelemetryFrame> batch(drivers.size());
+        size_t frameCount = 0;
 
-            if(!buffer.pop(frame)) {
+        while(!done.load()){
+            size_t count = render_feed.next(batch.data(), batch.size());
+            if(count == 0) {
                 break;
             }
 
-            track_limits_monitor.processFrame(frame);
-
-            latestFrames[frame.driver_id] = frame;
+            for(size_t i = 0; i < count; i++) {
+                latestFrames[batch[i].driver_id] = batch[i];
+            }
             
-            static size_t frameCount = 0;
-            frameCount++;
+            size_t prevFrameCount = frameCount;
+            frameCount += count;
             
-            if(frameCount % drivers.size() == 0) {
+            // Redraw once per completed tick
+            if(frameCount / drivers.size() != prevFrameCount / drivers.size()) {
                 cout << "\033[2J\033[H";
                 
                 uint32_t currentLap = 0;
@@ -213,7 +1013,7 @@ int main(){
                     cout << "\033[0m ";
                     
                     string emoji = "⚫";
-                    string teamName = cars[f.driver_id].car_id;
+                    string teamName = model->carName(f.driver_id);
                     if(teamName == "Red Bull") emoji = "🔵";
                     else if(teamName == "Ferrari") emoji = "🔴";
                     else if(teamName == "Mercedes") emoji = "⚪";
@@ -227,7 +1027,7 @@ int main(){
                     
                     cout << emoji << " ";
                     
-                    string name = drivers[f.driver_id].driver_id;
+                    string name = model->driverName(f.driver_id);
                     cout << "\033[1m" << name << "\033[0m";
                     for(size_t i = name.length(); i < 20; i++) cout << " ";
                     
@@ -272,7 +1072,7 @@ int main(){
                     
                     if(state.warnings > 0) {
                         any_violations = true;
-                        cout << "   " << drivers[f.driver_id].driver_id << ": ";
+                        cout << "   " << model->driverName(f.driver_id) << ": ";
                         cout << state.warnings << " warning" << (state.warnings > 1 ? "s" : "");
                         
                         // Add penalty status
@@ -291,6 +1091,22 @@ int main(){
                     cout << "   \033[90mNone\033[0m\n";
                 }
                 
+                {
+                    lock_guard<mutex> lock(strategy_mutex);
+                    if(!optimal_strategies.empty()) {
+                        cout << "\n📋 PLANNED STOPS:";
+                        for(const auto& entry : optimal_strategies) {
+                            cout << "  " << model->driverName(entry.first) << " L" << entry.second;
+                        }
+                        cout << "\n";
+                    }
+                }
+
+                if(const char* phase = analysis_phase.load(memory_order_acquire)) {
+                    cout << "\n🧠 STRATEGY ANALYSIS: " << phase << " " << analysis_done.load(memory_order_relaxed)
+                         << "/" << analysis_total.load(memory_order_relaxed) << "\n";
+                }
+
                 cout << "\033[90mRace runs until finish\033[0m\n";
                 cout.flush();
             }
@@ -298,7 +1114,113 @@ int main(){
     });
 
     producer.join();
-    consumer.join();
+    race_control.join();
+    if(renderer.joinable()) renderer.join();
+    if(strategist.joinable()) strategist.join();
+    if(replanner.joinable()) replanner.join();
+    if(recorder && !recorder->finish()) {
+        cerr << "Write to " << recorder->path() << " failed; the recording is incomplete\n";
+    }
+
+    if(!driver_ids.empty()) {
+        cout << "\nStrategy Analysis Results:\n";
+        cout << "==========================\n";
+        for(const auto& entry : optimal_strategies) {
+            cout << model->driverName(entry.first) 
+                << ": Pit lap " << entry.second 
+                << " (finish time: " << (planned_finish_times[entry.first] / 60.0f) << " min)\n";
+        }
+
+        cout << "\nBest plans with up to " << MultiStopOptimizer::DEFAULT_MAX_STOPS << " stops:\n";
+        for(const auto& plan : multi_stop_plans) {
+            cout << model->driverName(plan.driver_id) << ": " << formatStops(plan.pit_laps)
+                << " (finish time: " << (plan.finish_time_seconds / 60.0f) << " min)\n";
+        }
+        if(multi_stop_plans.size() < driver_ids.size()) {
+            cout << "(stopped at the flag; " << driver_ids.size() - multi_stop_plans.size() << " not planned)\n";
+        }
+
+        if(options.monte_carlo_trials > 0 && monte_carlo_results.size() < driver_ids.size()) {
+            cout << "\nMonte Carlo stopped at the flag after " << monte_carlo_results.size() << " of "
+                 << driver_ids.size() << " drivers\n";
+        }
+        if(!monte_carlo_results.empty()) {
+            cout << "\nMonte Carlo (safety car p=" << track.safety_car_probability << "/lap):\n";
+            for(const auto& mc_result : monte_carlo_results) {
+                cout << model->driverName(mc_result.driver_id) << ": best pit lap " << mc_result.best_pit_lap
+                     << " after " << mc_result.trials << " trials"
+                     << (mc_result.separated ? "" : " (not separated)") << "\n";
+                for(const auto& c : mc_result.candidates) {
+                    cout << "  lap " << setw(2) << c.pit_lap << fixed << setprecision(2)
+                         << "  mean " << c.mean_seconds << "s  p10 " << c.p10_seconds
+                         << "s  p90 " << c.p90_seconds << "s  win " << setprecision(1)
+                         << c.win_probability * 100.0f << "%\n" << defaultfloat << setprecision(6);
+                }
+            }
+        }
+    }
+
+    if(options.headless) {
+        const double wall_seconds = chrono::duration<double>(chrono::steady_clock::now() - race_start).count();
+        const double sim_seconds = ticks * 0.02;
+
+        vector<TelemetryFrame> classification = final_frames;
+        sort(classification.begin(), classification.end(),
+                [](const TelemetryFrame& a, const TelemetryFrame& b) {
+                    return a.race_position < b.race_position;
+                });
+
+        cout << "\nFinal classification:\n";
+        cout << "=====================\n";
+        for(const auto& f : classification) {
+            cout << "P" << left << setw(3) << int(f.race_position)
+                 << setw(20) << model->driverName(f.driver_id) << right
+                 << " Lap " << f.lap
+                 << "  Tire " << int(f.tire_wear * 100) << "%\n";
+        }
+
+        cout << "\nTiming:\n";
+        cout << "=======\n";
+        cout << "Ticks:            " << ticks << "\n";
+        cout << "First frame:      " << fixed << setprecision(3)
+             << chrono::duration<double, milli>(first_frame_time - launch_time).count() << " ms after launch\n";
+        cout << "Simulated time:   " << fixed << setprecision(1) << sim_seconds << " s\n";
+        cout << "Wall time:        " << setprecision(3) << wall_seconds << " s\n";
+        cout << "Speed-up:         " << setprecision(1) << (wall_seconds > 0 ? sim_seconds / wall_seconds : 0.0) << "x\n";
+        cout << "Frames published: " << bus.published() << "\n";
+        if(replay) {
+            cout << "Replayed from:    " << options.replay_path << " (" << replay->frameCount() << " frames recorded, "
+                 << replay->framesDropped() << " dropped when recording)\n";
+        }
+        cout << "Overtakes:        " << overtakes << "\n";
+        if(!driver_ids.empty()) {
+            cout << "Live replans:     " << replans << " (" << replans_changed << " plan changes, worst "
+                 << setprecision(3) << worst_replan_ms << " ms";
+            if(plans_in_lockstep) cout << ", in lockstep)\n";
+            else cout << " of " << live_optimizer.budget().count() / 1000.0 << " ms budget)\n";
+        }
+        cout << "Ticks per second: " << setprecision(0) << (wall_seconds > 0 ? ticks / wall_seconds : 0.0) << "\n";
+        if(recorder) {
+            const TelemetryRecorder::Stats stats = recorder->stats();
+            cout << "Recorded:         " << stats.frames << " frames (" << setprecision(1)
+                 << stats.bytes / (1024.0 * 1024.0) << " MB in " << stats.writes << " writes), dropped "
+                 << stats.dropped << ", write " << setprecision(3) << stats.write_ms << " ms, reader wait "
+                 << stats.reader_wait_ms << " ms\n";
+        }
+    }
+
+    if(!max_speed) {
+        cout << "\n";
+        scheduler.lateness().print(cout);
+        if(scheduler.skippedTicks() > 0) {
+            cout << "Skipped ticks: " << scheduler.skippedTicks() << "\n";
+        }
+    }
+
+    if(race_control_feed.lapped() > 0 || render_feed.lapped() > 0) {
+        cout << "[Telemetry] Frames skipped by slow subscribers - race control: " << race_control_feed.lapped()
+             << ", renderer: " << render_feed.lapped() << "\n";
+    }
 
     return 0;
 }
\ No newline at end of file
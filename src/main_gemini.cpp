@@ -1,17 +1,25 @@
-#include "ingestion/RingBuffer.h"
+#include "ingestion/BroadcastBus.h"
+#include "ingestion/IngestionQueue.h"
 #include "telemetry/TelemetryGenerator.h"
+#include "telemetry/TickScheduler.h"
 #include "strategy/StrategyAnalyzer.h"
+#include "strategy/LiveStrategyOptimizer.h"
+#include "strategy/StrategySurrogate.h"
 #include "data/season_data.h"
 #include "race-control/TrackLimitsMonitor.h"
 #include "race-control/PenaltyEnforcer.h"
+#include "recording/ReplaySource.h"
 #include <thread>
+#include <mutex>
 #include <chrono>
 #include <iostream>
 #include <fstream>
 #include <vector>
 #include <atomic>
+#include <memory>
 #include <algorithm>
 #include <sstream>
+#include <cstring>
 
 using namespace std;
 
@@ -21,7 +29,8 @@ void outputJsonTelemetry(const TelemetryFrame& frame,
                          uint32_t optimal_pit_lap,
                          uint32_t total_laps,
                          float overtaking_difficulty,
-                         float safety_car_prob) {
+                         float safety_car_prob,
+                         const SurrogateAnswer* from_here) {
     // Output compact JSON to stdout for Python to consume
     cout << "{";
     cout << "\"driver_id\":" << frame.driver_id << ",";
@@ -39,6 +48,12 @@ void outputJsonTelemetry(const TelemetryFrame& frame,
     cout << "\"tire_management\":" << driver.tire_management << ",";
     cout << "\"consistency\":" << driver.consistency << ",";
     cout << "\"optimal_pit_lap\":" << optimal_pit_lap << ",";
+    if(from_here) {
+        // Best single stop from this lap boundary (0 = run to the flag), from the surrogate table
+        cout << "\"best_pit_lap_from_here\":" << (from_here->stop ? frame.lap + from_here->laps_until_stop : 0) << ",";
+        cout << "\"best_pit_lap_error_s\":" << from_here->error_seconds << ",";
+        cout << "\"best_pit_lap_decisive\":" << (from_here->decisive ? "true" : "false") << ",";
+    }
     cout << "\"overtaking_difficulty\":" << overtaking_difficulty << ",";
     cout << "\"safety_car_prob\":" << safety_car_prob;
     cout << "}" << endl;
@@ -62,6 +77,15 @@ vector<uint32_t> parseDriverIds(const string& input, size_t max_id){
     return driver_ids;
 }
 
+string formatStops(const vector<uint32_t>& pit_laps){
+    if(pit_laps.empty()) return "No stop";
+    string text = pit_laps.size() == 1 ? "Pit lap" : "Pit laps";
+    for(size_t i = 0; i < pit_laps.size(); i++){
+        text += (i == 0 ? " " : ", ") + to_string(pit_laps[i]);
+    }
+    return text;
+}
+
 int main(){
 
     atomic<bool> done(false);
@@ -87,6 +111,26 @@ int main(){
         cerr << "FARVIS MODE: Outputting JSON telemetry for Gemini AI\n";
     }
 
+    // FARVIS_REPLAY=<log> plays back a race recorded with f1-telemetry --record instead
+    // of simulating one; FARVIS_REPLAY_SPEED=N|max paces it at N times real time or
+    // as fast as race control keeps up.
+    unique_ptr<ReplaySource> replay;
+    double replay_speed = 1.0;
+    if(const char* replay_path = getenv("FARVIS_REPLAY")) {
+        replay = make_unique<ReplaySource>(replay_path);
+        if(!replay->isOpen() || replay->driverCount() != drivers.size()) {
+            cerr << "Could not replay " << replay_path << ": not a telemetry log for this field\n";
+            return 1;
+        }
+        if(const char* speed = getenv("FARVIS_REPLAY_SPEED")) {
+            if(strcmp(speed, "max") == 0) {
+                replay_speed = 0.0;
+            } else if(atof(speed) > 0.0) {
+                replay_speed = atof(speed);
+            }
+        }
+    }
+
     // Ask user about strategy optimization
     if(!gemini_mode) {
         cerr << "\nRun strategy analysis? (y/n): ";
@@ -94,7 +138,7 @@ int main(){
     string response;
     getline(cin, response);
 
-    map<uint32_t, uint32_t> optimal_strategies;
+    vector<uint32_t> driver_ids;
 
     if (response == "y" || response == "Y") {
         if(!gemini_mode) {
@@ -108,41 +152,111 @@ int main(){
         string input;
         getline(cin, input);
         
-        vector<uint32_t> driver_ids = parseDriverIds(input, drivers.size());
-        
-        if(!driver_ids.empty()) {
-            if(!gemini_mode) {
-                cerr << "\nAnalyzing strategies (this may take 10-30 seconds)...\n";
+        driver_ids = parseDriverIds(input, drivers.size());
+    }
+    // A replayed race already ran its stops; planning against it would mislabel the feed
+    if(replay) driver_ids.clear();
+
+    // One immutable copy of the race inputs, shared by everything below
+    auto model = RaceModel::create(track, drivers, cars, total_laps);
+    auto penalty_enforcer = std::make_shared<PenaltyEnforcer>(*model);
+
+    // "Best stop from here" lookups for the JSON feed; the table is built once per
+    // track and race length (or ahead of time with f1-telemetry --build-surrogate).
+    auto surrogate = make_unique<StrategySurrogate>(model);
+    if(!surrogate->isOpen() && StrategySurrogate::build(*model)) {
+        surrogate = make_unique<StrategySurrogate>(model);
+    }
+
+    // Each frame is published once; every stage reads it on its own thread through its own
+    // cursor, and a stage that falls behind (usually the terminal) is lapped rather than
+    // holding up race control.
+    BroadcastBus<TelemetryFrame> bus(4096);
+    TelemetryGenerator generator(model, penalty_enforcer);
+    TrackLimitsMonitor track_limits_monitor(model, penalty_enforcer);
+
+    // Strategy analysis runs alongside the race; planned stops reach the generator (and the
+    // JSON feed) as soon as each driver's search produces them.
+    // The cache file is only touched when there is analysis to memoize
+    unique_ptr<StrategyCache> cache;
+    if(!driver_ids.empty()) cache = make_unique<StrategyCache>();
+    StrategyAnalyzer analyzer(model, WorkStealingPool::shared(), cache.get());
+    mutex strategy_mutex;
+    map<uint32_t, uint32_t> optimal_strategies;
+    map<uint32_t, float> planned_finish_times;
+    vector<StopPlan> multi_stop_plans;
+
+    // What the strategist is working on, for the leaderboard: the phase (null once
+    // idle) and its (jobs finished, jobs total).
+    atomic<const char*> analysis_phase(nullptr);
+    atomic<size_t> analysis_done(0);
+    atomic<size_t> analysis_total(0);
+    auto progressOf = [&](const char* phase) -> StrategyProgress {
+        return [&, phase](size_t done, size_t total) {
+            analysis_done.store(done, memory_order_relaxed);
+            analysis_total.store(total, memory_order_relaxed);
+            analysis_phase.store(phase, memory_order_release);
+        };
+    };
+
+    thread strategist;
+    if(!driver_ids.empty()) strategist = thread([&]() {
+        analyzer.analyzeProgressive(driver_ids, [&](const StrategyResult& result) {
+            lock_guard<mutex> lock(strategy_mutex);
+            optimal_strategies[result.driver_id] = result.optimal_pit_lap;
+            planned_finish_times[result.driver_id] = result.finish_time_seconds;
+            generator.setOptimalStrategies(optimal_strategies);
+        }, progressOf("pit stop search"));
+
+        // Advisory only: the live race executes one planned stop
+        multi_stop_plans = analyzer.analyzeMultiStop(driver_ids, MultiStopOptimizer::DEFAULT_MAX_STOPS,
+                                                     progressOf("multi-stop plans"));
+        analysis_phase.store(nullptr, memory_order_release);
+    });
+
+    // Once racing, re-plan the remaining race from the live state each time the leader
+    // starts a lap, within LiveStrategyOptimizer's latency budget, and swap in any change.
+    const RaceSimulator live_simulator(model);
+    const LiveStrategyOptimizer live_optimizer(live_simulator);
+    uint64_t replans = 0;
+    uint64_t replans_changed = 0;
+    double worst_replan_ms = 0.0;
+
+    thread replanner;
+    if(!driver_ids.empty()) replanner = thread([&]() {
+        uint64_t last_snapshot_ns = UINT64_MAX;
+        while(!done.load()) {
+            auto snapshot = generator.latestSnapshot();
+            if(!snapshot || snapshot->timestamp_ns == last_snapshot_ns) {
+                this_thread::sleep_for(chrono::milliseconds(2));
+                continue;
             }
-            
-            StrategyAnalyzer analyzer(track, drivers, cars, total_laps);
-            vector<StrategyResult> results = analyzer.analyzeStrategies(driver_ids);
-            
-            if(!gemini_mode) {
-                cerr << "\nStrategy Analysis Results:\n";
-                cerr << "==========================\n";
+            last_snapshot_ns = snapshot->timestamp_ns;
+
+            map<uint32_t, uint32_t> plan;
+            {
+                lock_guard<mutex> lock(strategy_mutex);
+                plan = optimal_strategies;
             }
-            for(const auto& result : results) {
-                if(!gemini_mode) {
-                    cerr << drivers[result.driver_id].driver_id 
-                        << ": Pit lap " << result.optimal_pit_lap 
-                        << " (finish time: " << (result.finish_time_seconds / 60.0f) << " min)\n";
+            if(plan.empty()) continue;
+
+            ReplanReport report = live_optimizer.reoptimize(*snapshot, plan);
+            replans++;
+            worst_replan_ms = max(worst_replan_ms, report.elapsed_ms);
+
+            lock_guard<mutex> lock(strategy_mutex);
+            bool changed = false;
+            for(const auto& replan : report.plans) {
+                auto it = optimal_strategies.find(replan.driver_id);
+                if(it != optimal_strategies.end() && it->second != replan.pit_lap) {
+                    it->second = replan.pit_lap;
+                    changed = true;
+                    replans_changed++;
                 }
-                optimal_strategies[result.driver_id] = result.optimal_pit_lap;
             }
-            if(!gemini_mode) cerr << "\n";
+            if(changed) generator.setOptimalStrategies(optimal_strategies);
         }
-    }
-
-    auto penalty_enforcer = std::make_shared<PenaltyEnforcer>(drivers);
-
-    RingBuffer<TelemetryFrame> buffer(1024);
-    TelemetryGenerator generator(track, drivers, cars, total_laps, penalty_enforcer);
-    TrackLimitsMonitor track_limits_monitor(track, drivers, penalty_enforcer);
-
-    if(!optimal_strategies.empty()) {
-        generator.setOptimalStrategies(optimal_strategies);
-    }
+    });
 
     // Select driver for FARVIS AI coaching (Gemini mode only)
     vector<uint32_t> json_output_drivers;
@@ -154,7 +268,7 @@ int main(){
         
         cerr << "Available drivers:\n";
         for(uint32_t i = 0; i < drivers.size(); i++) {
-            cerr << "  " << i << ": " << drivers[i].driver_id;
+            cerr << "  " << i << ": " << model->driverName(i);
             cerr << " (Aggression: " << drivers[i].aggression;
             cerr << ", Tire Mgmt: " << drivers[i].tire_management << ")\n";
         }
@@ -167,7 +281,7 @@ int main(){
             int driver_choice = stoi(input);
             if(driver_choice >= 0 && static_cast<size_t>(driver_choice) < drivers.size()) {
                 json_output_drivers.push_back(static_cast<uint32_t>(driver_choice));
-                cerr << "\nFARVIS will coach " << drivers[driver_choice].driver_id << "!\n";
+                cerr << "\nFARVIS will coach " << model->driverName(driver_choice) << "!\n";
             } else {
                 cerr << "\nInvalid choice, defaulting to Verstappen\n";
                 json_output_drivers.push_back(0);
@@ -184,14 +298,14 @@ int main(){
     } else {
         cerr << "\nRace strategies:\n";
         cerr << "================\n";
-        for (uint32_t i = 0; i < drivers.size(); i++) {
-            cerr << drivers[i].driver_id << ": ";
-            auto it = optimal_strategies.find(i);
-            if (it != optimal_strategies.end()) {
-                cerr << "Optimal pit lap " << it->second << "\n";
-            } else {
-                cerr << "Wear-based pitting\n";
+        if(driver_ids.empty()) {
+            cerr << "Wear-based pitting for all drivers\n";
+        } else {
+            cerr << "Wear-based pitting until analysis publishes a plan for:";
+            for(size_t i = 0; i < driver_ids.size(); i++) {
+                cerr << (i == 0 ? " " : ", ") << model->driverName(driver_ids[i]);
             }
+            cerr << "\n";
         }
         cerr << "\nPress Enter to start race...\n";
         cerr.flush();
@@ -205,18 +319,50 @@ int main(){
         json_output_drivers = {0, 1, 2};
     }
 
+    auto race_control_feed = bus.subscribe();
+    auto json_feed = bus.subscribe();
+    auto render_feed = bus.subscribe();
+
+    // Absolute 50 Hz deadlines: the Python engineer assumes a steady cadence. Only a
+    // replay may run faster.
+    const bool max_speed = replay_speed == 0.0;
+    TickScheduler scheduler(chrono::duration_cast<chrono::nanoseconds>(
+        chrono::duration<double, milli>(max_speed ? 20.0 : 20.0 / replay_speed)), CatchUpPolicy::CATCH_UP);
+
     thread producer([&]() {
+        // Reused every tick so the steady-state producer loop never touches the heap
+        FrameBatch batch;
+        vector<TelemetryFrame> frames;
+        frames.reserve(drivers.size());
+        // A replayed tick is published straight out of the log mapping
+        const TelemetryFrame* tick = nullptr;
+        size_t tick_size = 0;
+        scheduler.start();
+
         while(!done.load()){
-            auto frames = generator.next();
+            bool finished;
+            if(replay) {
+                // A log ends one tick before the finish; its last tick decides the winner
+                finished = !replay->nextTick(tick, tick_size);
+                if(finished) frames.assign(tick, tick + tick_size);
+            } else {
+                generator.nextInto(batch);
+                batch.toFrames(frames);
+                finished = generator.isRaceFinished();
+                tick = frames.data();
+                tick_size = frames.size();
+            }
 
-            if(generator.isRaceFinished()) {
+            if(finished) {
                 done.store(true);
-                buffer.shutdown();
+                bus.shutdown();
+                // Nobody should wait past the flag for the advisory reports
+                analyzer.cancel();
                 
                 string winner = "";
                 for(const auto& frame : frames) {
                     if(frame.race_position == 1) {
-                        winner = drivers[frame.driver_id].driver_id;
+                        winner = model->driverName(frame.driver_id);
                         break;
                     }
                 }
@@ -229,21 +375,92 @@ int main(){
                 break;
             }
 
-            for(const auto &frame : frames){
-                if(!buffer.push(frame)){
-                    TelemetryFrame old_frame;
-                    buffer.pop(old_frame);
-                    if(!gemini_mode) {
-                        cerr << "[Telemetry] Buffer full, dropping frame " << drivers[old_frame.driver_id].driver_id << "\n";
+            // Publish the whole tick at once; never waits on subscribers.
+            bus.publishBatch(tick, tick_size);
+            if(max_speed) {
+                while(bus.published() - race_control_feed.consumed() > bus.capacity() / 2) {
+                    this_thread::yield();
+                }
+            } else {
+                scheduler.waitNextTick();
+            }
+        }
+    });
+
+    // Race control consumes every frame on its own thread so penalty enforcement never
+    // waits for the JSON pipe or a terminal redraw.
+    thread race_control([&]() {
+        vector<TelemetryFrame> batch(drivers.size());
+        size_t count;
+        while((count = race_control_feed.next(batch.data(), batch.size())) > 0) {
+            track_limits_monitor.processFrames(batch.data(), count);
+        }
+    });
+
+    // The coached drivers' frames reach the JSON emitter through a queue whose policy
+    // (F1_BACKPRESSURE=block|drop-newest|drop-oldest|conflate, default conflate) decides
+    // what a slow Python reader loses; only this pump waits on it, never the bus.
+    BackpressurePolicy backpressure = parseBackpressurePolicy(getenv("F1_BACKPRESSURE"), BackpressurePolicy::CONFLATE);
+    IngestionQueue<TelemetryFrame> json_queue(1024, backpressure);
+
+    thread json_pump([&]() {
+        vector<TelemetryFrame> batch(drivers.size());
+        vector<TelemetryFrame> coached;
+        coached.reserve(drivers.size());
+        size_t count;
+        while((count = json_feed.next(batch.data(), batch.size())) > 0) {
+            if(!gemini_mode) continue;
+            coached.clear();
+            for(size_t b = 0; b < count; b++) {
+                if(find(json_output_drivers.begin(), json_output_drivers.end(), batch[b].driver_id) != json_output_drivers.end()) {
+                    coached.push_back(batch[b]);
+                }
+            }
+            if(!coached.empty()) json_queue.pushBatch(coached.data(), coached.size());
+        }
+        json_queue.shutdown();
+    });
+
+    // Gemini JSON emitter
+    thread json_emitter([&]() {
+        // Track last lap output per driver
+        map<uint32_t, uint32_t> last_json_output_lap_per_driver;
+        vector<TelemetryFrame> batch(drivers.size());
+        size_t count;
+        
+        while((count = json_queue.popBatch(batch.data(), batch.size())) > 0) {
+            for(size_t b = 0; b < count; b++) {
+                const TelemetryFrame& frame = batch[b];
+                
+                // Output JSON for Gemini (every lap for each coached driver)
+                uint32_t current_lap = frame.lap;
+                uint32_t last_lap = last_json_output_lap_per_driver[frame.driver_id];
+        
+                // Output at lap completion: the first frame of a new lap that got through
+                // (usually its sector 1; conflation may have replaced that one)
+                if(current_lap > last_lap && current_lap > 1) {
+                    uint32_t opt_pit = 0;
+                    {
+                        lock_guard<mutex> lock(strategy_mutex);
+                        auto opt_it = optimal_strategies.find(frame.driver_id);
+                        if(opt_it != optimal_strategies.end()) opt_pit = opt_it->second;
                     }
-                    buffer.push(frame);
+            
+                    SurrogateAnswer from_here;
+                    const bool answered = surrogate->bestStop(frame.driver_id, total_laps - frame.lap,
+                                                              frame.tire_wear, from_here);
+                    outputJsonTelemetry(frame, drivers[frame.driver_id], opt_pit, 
+                                      total_laps, track.overtaking_difficulty, 
+                                      track.safety_car_probability,
+                                      answered ? &from_here : nullptr);
+            
+                    last_json_output_lap_per_driver[frame.driver_id] = current_lap;
                 }
             }
-            this_thread::sleep_for(chrono::milliseconds(20));
         }
     });
 
-    thread consumer([&]() {
+    thread renderer([&]() {
         vector<TelemetryFrame> latestFrames(drivers.size());
         for(size_t i = 0; i < latestFrames.size(); i++) {
             latestFrames[i].driver_id = static_cast<uint32_t>(i);
@@ -252,44 +469,25 @@ int main(){
             latestFrames[i].sector = 1;
         }
         
-        // Track last lap output per driver
-        map<uint32_t, uint32_t> last_json_output_lap_per_driver;
+        // Drain up to a full tick per wakeup
+        vector<TelemetryFrame> batch(drivers.size());
+        size_t frameCount = 0;
         
         while(!done.load()){
-            TelemetryFrame frame;
-
-            if(!buffer.pop(frame)) {
+            size_t count = render_feed.next(batch.data(), batch.size());
+            if(count == 0) {
                 break;
             }
-
-            track_limits_monitor.processFrame(frame);
-            latestFrames[frame.driver_id] = frame;
             
-            // Output JSON for Gemini (every lap for chosen driver)
-            if(gemini_mode && 
-               find(json_output_drivers.begin(), json_output_drivers.end(), frame.driver_id) != json_output_drivers.end()) {
-                
-                uint32_t current_lap = frame.lap;
-                uint32_t last_lap = last_json_output_lap_per_driver[frame.driver_id];
-                
-                // Output at lap completion (sector 1 of new lap)
-                if(current_lap > last_lap && frame.sector == 1 && current_lap > 1) {
-                    auto opt_it = optimal_strategies.find(frame.driver_id);
-                    uint32_t opt_pit = (opt_it != optimal_strategies.end()) ? opt_it->second : 0;
-                    
-                    outputJsonTelemetry(frame, drivers[frame.driver_id], opt_pit, 
-                                      total_laps, track.overtaking_difficulty, 
-                                      track.safety_car_probability);
-                    
-                    last_json_output_lap_per_driver[frame.driver_id] = current_lap;
-                }
+            for(size_t i = 0; i < count; i++) {
+                latestFrames[batch[i].driver_id] = batch[i];
             }
             
-            static size_t frameCount = 0;
-            frameCount++;
+            size_t prevFrameCount = frameCount;
+            frameCount += count;
             
             // Display telemetry leaderboard (both modes, but only in Gemini mode show coaching indicator)
-            if(frameCount % drivers.size() == 0) {
+            if(frameCount / drivers.size() != prevFrameCount / drivers.size()) {
                 cerr << "\033[2J\033[H";
                 
                 uint32_t currentLap = 0;
@@ -327,7 +525,7 @@ int main(){
                         cerr << "    ";
                     }
                     
-                    string name = drivers[f.driver_id].driver_id;
+                    string name = model->driverName(f.driver_id);
                     cerr << name;
                     for(size_t i = name.length(); i < 20; i++) cerr << " ";
                     
@@ -364,7 +562,7 @@ int main(){
                     
                     if(state.warnings > 0) {
                         any_violations = true;
-                        cerr << "   " << drivers[f.driver_id].driver_id << ": ";
+                        cerr << "   " << model->driverName(f.driver_id) << ": ";
                         cerr << state.warnings << " warning" << (state.warnings > 1 ? "s" : "");
                         
                         if(penalty.state == PenaltyState::PENDING) {
@@ -382,6 +580,11 @@ int main(){
                     cerr << "   \033[90mNone\033[0m\n";
                 }
                 
+                if(const char* phase = analysis_phase.load(memory_order_acquire)) {
+                    cerr << "\n🧠 STRATEGY ANALYSIS: " << phase << " " << analysis_done.load(memory_order_relaxed)
+                         << "/" << analysis_total.load(memory_order_relaxed) << "\n";
+                }
+
                 cerr << "\033[90mRace runs until finish\033[0m\n";
                 cerr.flush();
             }
@@ -389,7 +592,47 @@ int main(){
     });
 
     producer.join();
-    consumer.join();
+    race_control.join();
+    json_pump.join();
+    json_emitter.join();
+    renderer.join();
+    if(strategist.joinable()) strategist.join();
+    if(replanner.joinable()) replanner.join();
+
+    if(!gemini_mode && !driver_ids.empty()) {
+        cerr << "\nStrategy Analysis Results:\n";
+        cerr << "==========================\n";
+        for(const auto& entry : optimal_strategies) {
+            cerr << model->driverName(entry.first) 
+                << ": Pit lap " << entry.second 
+                << " (finish time: " << (planned_finish_times[entry.first] / 60.0f) << " min)\n";
+        }
+        cerr << "\nBest plans with up to " << MultiStopOptimizer::DEFAULT_MAX_STOPS << " stops:\n";
+        for(const auto& plan : multi_stop_plans) {
+            cerr << model->driverName(plan.driver_id) << ": " << formatStops(plan.pit_laps)
+                << " (finish time: " << (plan.finish_time_seconds / 60.0f) << " min)\n";
+        }
+        if(multi_stop_plans.size() < driver_ids.size()) {
+            cerr << "(stopped at the flag; " << driver_ids.size() - multi_stop_plans.size() << " not planned)\n";
+        }
+        cerr << "\nLive replans: " << replans << " (" << replans_changed << " plan changes, worst "
+             << worst_replan_ms << " ms of " << live_optimizer.budget().count() / 1000.0 << " ms budget)\n";
+    }
+
+    if(!gemini_mode && (race_control_feed.lapped() > 0 || json_feed.lapped() > 0 || render_feed.lapped() > 0)) {
+        cerr << "[Telemetry] Frames skipped by slow subscribers - race control: " << race_control_feed.lapped()
+             << ", json: " << json_feed.lapped() << ", renderer: " << render_feed.lapped() << "\n";
+    }
+    IngestionStats json_stats = json_queue.stats();
+    if(json_stats.dropped > 0 || json_stats.conflated > 0) {
+        cerr << "[Telemetry] JSON feed: " << json_stats.dropped << " frames dropped, "
+             << json_stats.conflated << " conflated\n";
+    }
+
+    if(!gemini_mode) {
+        cerr << "\n";
+        scheduler.lateness().print(cerr);
+    }
 
     return 0;
 }
@@ -0,0 +1,159 @@
+#include "TickKernel.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define TICK_KERNEL_X86 1
+#include <immintrin.h>
+#endif
+
+namespace TickKernel {
+
+namespace {
+
+// Same operation order as the original per-driver code so both paths agree bit-for-bit
+// when no FMA contraction happens.
+inline void advanceLane(const TickParams& p, const DriverLanes& l, size_t i) {
+    if (!l.moving[i]) {
+        l.speed[i] = 0.0f;
+        return;
+    }
+
+    const float speed = l.base_speed[i] * (1.0f - l.tire_wear[i] * 0.4f);
+    const float delta_distance_km = speed * (TICK_SECONDS / 3600.0f) * SIM_SPEED_MULTIPLIER;
+
+    float wear = l.tire_wear[i] + (delta_distance_km / p.lap_length_km) * l.wear_per_lap[i];
+    if (wear > 1.0f) wear = 1.0f;
+    l.tire_wear[i] = wear;
+
+    float distance = l.distance_in_lap[i] + delta_distance_km;
+    uint32_t sector = l.sector[i];
+    uint32_t lap = l.lap[i];
+    while (distance >= p.sector_length_km) {
+        distance -= p.sector_length_km;
+        sector++;
+        if (sector > p.sectors) {
+            sector = 1;
+            lap++;
+        }
+    }
+    l.distance_in_lap[i] = distance;
+    l.sector[i] = sector;
+    l.lap[i] = lap;
+    l.speed[i] = speed;
+}
+
+#ifdef TICK_KERNEL_X86
+__attribute__((target("avx2")))
+void advanceAvx2(const TickParams& p, const DriverLanes& l, size_t n) {
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 wear_speed_loss = _mm256_set1_ps(0.4f);
+    const __m256 km_per_kph_tick = _mm256_set1_ps(TICK_SECONDS / 3600.0f);
+    const __m256 multiplier = _mm256_set1_ps(SIM_SPEED_MULTIPLIER);
+    const __m256 lap_length = _mm256_set1_ps(p.lap_length_km);
+    const __m256 sector_length = _mm256_set1_ps(p.sector_length_km);
+    const __m256i sectors = _mm256_set1_epi32(static_cast<int>(p.sectors));
+    const __m256i one_i = _mm256_set1_epi32(1);
+
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        // moving[] is bytes; widen to a 32-bit lane mask
+        const __m128i moving_bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(l.moving + i));
+        const __m256i moving_i = _mm256_cvtepu8_epi32(moving_bytes);
+        const __m256 moving = _mm256_castsi256_ps(_mm256_cmpgt_epi32(moving_i, _mm256_setzero_si256()));
+
+        const __m256 base_speed = _mm256_loadu_ps(l.base_speed + i);
+        const __m256 wear_per_lap = _mm256_loadu_ps(l.wear_per_lap + i);
+        __m256 wear = _mm256_loadu_ps(l.tire_wear + i);
+        __m256 distance = _mm256_loadu_ps(l.distance_in_lap + i);
+        __m256i sector = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(l.sector + i));
+        __m256i lap = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(l.lap + i));
+
+        const __m256 speed = _mm256_mul_ps(base_speed, _mm256_sub_ps(one, _mm256_mul_ps(wear, wear_speed_loss)));
+        const __m256 delta = _mm256_mul_ps(_mm256_mul_ps(speed, km_per_kph_tick), multiplier);
+
+        __m256 new_wear = _mm256_add_ps(wear, _mm256_mul_ps(_mm256_div_ps(delta, lap_length), wear_per_lap));
+        new_wear = _mm256_min_ps(new_wear, one);
+        __m256 new_distance = _mm256_add_ps(distance, delta);
+
+        // One sector rollover in-lane; a second (only possible with huge ticks) is
+        // finished by the scalar loop below.
+        const __m256 crossed = _mm256_and_ps(_mm256_cmp_ps(new_distance, sector_length, _CMP_GE_OQ), moving);
+        const __m256i crossed_i = _mm256_castps_si256(crossed);
+        new_distance = _mm256_sub_ps(new_distance, _mm256_and_ps(sector_length, crossed));
+        __m256i new_sector = _mm256_sub_epi32(sector, crossed_i);   // mask is -1 => +1
+        const __m256i wrapped = _mm256_cmpgt_epi32(new_sector, sectors);
+        new_sector = _mm256_blendv_epi8(new_sector, one_i, wrapped);
+        const __m256i new_lap = _mm256_sub_epi32(lap, wrapped);
+
+        wear = _mm256_blendv_ps(wear, new_wear, moving);
+        distance = _mm256_blendv_ps(distance, new_distance, moving);
+        sector = _mm256_blendv_epi8(sector, new_sector, _mm256_castps_si256(moving));
+        lap = _mm256_blendv_epi8(lap, new_lap, _mm256_castps_si256(moving));
+
+        _mm256_storeu_ps(l.tire_wear + i, wear);
+        _mm256_storeu_ps(l.distance_in_lap + i, distance);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(l.sector + i), sector);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(l.lap + i), lap);
+        _mm256_storeu_ps(l.speed + i, _mm256_and_ps(speed, moving));
+
+        const __m256 again = _mm256_and_ps(_mm256_cmp_ps(distance, sector_length, _CMP_GE_OQ), moving);
+        int pending = _mm256_movemask_ps(again);
+        while (pending) {
+            const int lane = __builtin_ctz(pending);
+            pending &= pending - 1;
+            const size_t d = i + lane;
+            while (l.distance_in_lap[d] >= p.sector_length_km) {
+                l.distance_in_lap[d] -= p.sector_length_km;
+                l.sector[d]++;
+                if (l.sector[d] > p.sectors) {
+                    l.sector[d] = 1;
+                    l.lap[d]++;
+                }
+            }
+        }
+    }
+
+    advanceScalar(p, l, i, n);
+}
+#endif
+
+using AdvanceFn = void (*)(const TickParams&, const DriverLanes&, size_t);
+
+void advanceScalarAll(const TickParams& p, const DriverLanes& l, size_t n) {
+    advanceScalar(p, l, 0, n);
+}
+
+AdvanceFn resolve() {
+#ifdef TICK_KERNEL_X86
+    if (hasAvx2()) return advanceAvx2;
+#endif
+    return advanceScalarAll;
+}
+
+const AdvanceFn dispatch = resolve();
+
+} // namespace
+
+void advanceScalar(const TickParams& params, const DriverLanes& lanes, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+        advanceLane(params, lanes, i);
+    }
+}
+
+void advance(const TickParams& params, const DriverLanes& lanes, size_t n) {
+    dispatch(params, lanes, n);
+}
+
+bool hasAvx2() {
+#ifdef TICK_KERNEL_X86
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+const char* activeIsa() {
+    return hasAvx2() ? "avx2" : "scalar";
+}
+
+} // namespace TickKernel
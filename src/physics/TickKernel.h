@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Vectorized per-tick physics shared by TelemetryGenerator and RaceSimulator.
+// Advances every driver's speed, tire wear and distance_in_lap in SIMD lanes
+// (AVX2 when the CPU has it, scalar otherwise; chosen once at runtime).
+// Lanes with moving[i] == 0 (in the pits / just pitted) are left untouched and
+// report speed 0. Pit decisions themselves stay with the caller.
+namespace TickKernel {
+
+    constexpr float TICK_SECONDS = 0.02f;
+    // Sim runs ~120x faster than real time for reasonable race duration
+    constexpr float SIM_SPEED_MULTIPLIER = 120.0f;
+
+    struct TickParams {
+        float lap_length_km;
+        float sector_length_km;
+        uint32_t sectors;
+    };
+
+    // Structure-of-arrays view over n drivers. Constants are per driver:
+    //   base_speed   = 220 * engine_power * (0.80 + consistency * 0.25)
+    //   wear_per_lap = 0.05 * aggression * tire_wear_factor
+    struct DriverLanes {
+        const float* base_speed;
+        const float* wear_per_lap;
+        const uint8_t* moving;
+
+        float* tire_wear;
+        float* distance_in_lap;
+        uint32_t* lap;
+        uint32_t* sector;
+
+        float* speed;   // out: kph this tick (0 for lanes that didn't move)
+    };
+
+    void advance(const TickParams& params, const DriverLanes& lanes, size_t n);
+
+    // Exposed so callers can cross-check the two paths.
+    void advanceScalar(const TickParams& params, const DriverLanes& lanes, size_t begin, size_t end);
+    bool hasAvx2();
+    const char* activeIsa();
+}
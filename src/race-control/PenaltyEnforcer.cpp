@@ -2,8 +2,8 @@
 
 using namespace std;
 
-PenaltyEnforcer::PenaltyEnforcer(const std::vector<DriverProfile>& drivers) {
-    for(uint32_t i = 0; i < drivers.size(); i++) {
+PenaltyEnforcer::PenaltyEnforcer(const RaceModel& model) {
+    for(uint32_t i = 0; i < model.driverCount(); i++) {
         penalties_.insert({i, {PenaltyState::NONE, 0, 0ULL, 0ULL}});
     }
 }
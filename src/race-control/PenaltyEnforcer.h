@@ -1,9 +1,11 @@
 #pragma once
 
 #include "../common/types.h"
+#include "../common/RaceModel.h"
 #include <map>
 #include <cstdint>
 #include <mutex>
+#include <vector>
 
 enum class PenaltyState {
     NONE,
@@ -22,7 +24,7 @@ struct DriverPenaltyInfo {
 
 class PenaltyEnforcer {
 public:
-    PenaltyEnforcer(const std::vector<DriverProfile>& drivers);
+    explicit PenaltyEnforcer(const RaceModel& model);
 
     void issuePenalty(uint32_t driver_id, uint32_t seconds);
     bool shouldServePenalty(uint32_t driver_id, uint64_t current_time_ns);
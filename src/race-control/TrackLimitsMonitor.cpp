@@ -9,11 +9,10 @@ static std::mt19937 gen(rd());
 std::uniform_real_distribution<float> dis(0.0f, 1.0f);
 
 TrackLimitsMonitor::TrackLimitsMonitor(
-    const TrackProfile &track,
-    const vector<DriverProfile> &drivers,
+    shared_ptr<const RaceModel> model,
     std::shared_ptr<PenaltyEnforcer> penalty_enforcer
-) : track_(track), drivers_(drivers), penalty_enforcer_(penalty_enforcer) {
-    for(uint32_t i = 0; i < drivers.size(); i++) {
+) : model_(move(model)), penalty_enforcer_(penalty_enforcer) {
+    for(uint32_t i = 0; i < model_->driverCount(); i++) {
         driver_violations_.insert({i, TrackLimitsState{0, false, {}}});
     }
 }
@@ -25,8 +24,7 @@ void TrackLimitsMonitor::processFrame(const TelemetryFrame &frame) {
     if (last_sector[frame.driver_id] != frame.sector) {
         last_sector[frame.driver_id] = frame.sector;
         
-        const auto &driver = drivers_[frame.driver_id];
-        float aggression_factor = driver.aggression * 0.01f;
+        float aggression_factor = model_->aggression()[frame.driver_id] * 0.01f;
         float speed_factor = (frame.speed_kph > 200.0f) ? 0.005f : 0.0f;
         float tire_wear_factor = (frame.tire_wear > 0.6f) ? frame.tire_wear * 0.01f : 0.0f;
         float violation_probability = aggression_factor + speed_factor + tire_wear_factor;
@@ -47,6 +45,12 @@ void TrackLimitsMonitor::processFrame(const TelemetryFrame &frame) {
     }
 }
 
+void TrackLimitsMonitor::processFrames(const TelemetryFrame *frames, size_t count) {
+    for(size_t i = 0; i < count; i++) {
+        processFrame(frames[i]);
+    }
+}
+
 TrackLimitsState TrackLimitsMonitor::getDriverState(uint32_t driver_id) const {
     lock_guard<mutex> lock(mutex_);
     return driver_violations_.at(driver_id);
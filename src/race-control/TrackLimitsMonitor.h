@@ -1,9 +1,11 @@
 #pragma once
 
 #include "../common/types.h"
+#include "../common/RaceModel.h"
 #include <vector>
 #include <map>
 #include <mutex>
+#include <memory>
 #include "PenaltyEnforcer.h"
 
 struct TrackLimitsState {
@@ -14,15 +16,15 @@ struct TrackLimitsState {
 
 class TrackLimitsMonitor{
 public:
-    TrackLimitsMonitor(const TrackProfile& track, const std::vector<DriverProfile>& drivers, std::shared_ptr<PenaltyEnforcer> penalty_enforcer);
+    TrackLimitsMonitor(std::shared_ptr<const RaceModel> model, std::shared_ptr<PenaltyEnforcer> penalty_enforcer);
 
     void processFrame(const TelemetryFrame& frame);
+    void processFrames(const TelemetryFrame* frames, size_t count);
 
     TrackLimitsState getDriverState(uint32_t driver_id) const;
 
 private:
-    TrackProfile track_;
-    std::vector<DriverProfile> drivers_;
+    std::shared_ptr<const RaceModel> model_;
     std::shared_ptr<PenaltyEnforcer> penalty_enforcer_;
 
     std::map<uint32_t, TrackLimitsState> driver_violations_;
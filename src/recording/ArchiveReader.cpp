@@ -0,0 +1,132 @@
+#include "ArchiveReader.h"
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+using namespace TelemetryArchive;
+
+ArchiveReader::ArchiveReader(const string& path)
+    : mapping_(nullptr), mapping_size_(0), base_(nullptr), chunks_end_(0), chunk_count_(0), frame_count_(0),
+      driver_count_(0), chunk_frames_(0), cursor_(0) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if(fd < 0) return;
+
+    struct stat st;
+    if(fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(ArchiveHeader) + sizeof(ArchiveFooter)) {
+        close(fd);
+        return;
+    }
+    const size_t size = static_cast<size_t>(st.st_size);
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);   // the mapping keeps the file alive
+    if(mapping == MAP_FAILED) return;
+    mapping_ = mapping;
+    mapping_size_ = size;
+    const uint8_t* base = static_cast<const uint8_t*>(mapping);
+
+    ArchiveHeader header;
+    ArchiveFooter footer;
+    memcpy(&header, base, sizeof(header));
+    memcpy(&footer, base + size - sizeof(footer), sizeof(footer));
+    if(memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.format_version != FORMAT_VERSION ||
+       memcmp(footer.magic, MAGIC, sizeof(MAGIC)) != 0 || footer.format_version != FORMAT_VERSION ||
+       footer.directory_offset < sizeof(ArchiveHeader) || footer.directory_offset > size - sizeof(footer) ||
+       (size - sizeof(footer) - footer.directory_offset) != footer.chunk_count * sizeof(ChunkEntry)) {
+        return;
+    }
+
+    directory_.resize(footer.chunk_count);
+    memcpy(directory_.data(), base + footer.directory_offset, directory_.size() * sizeof(ChunkEntry));
+    for(const ChunkEntry& entry : directory_) {
+        if(entry.offset < sizeof(ArchiveHeader) || entry.offset + sizeof(ChunkHeader) > footer.directory_offset) return;
+    }
+
+    chunks_end_ = footer.directory_offset;
+    chunk_count_ = footer.chunk_count;
+    frame_count_ = footer.frame_count;
+    driver_count_ = header.driver_count;
+    chunk_frames_ = header.chunk_frames;
+    base_ = base;
+    madvise(mapping_, mapping_size_, MADV_SEQUENTIAL);
+}
+
+ArchiveReader::~ArchiveReader() {
+    if(mapping_) munmap(mapping_, mapping_size_);
+}
+
+ChunkHeader ArchiveReader::chunkHeader(size_t chunk) const {
+    ChunkHeader header{};
+    if(base_ && chunk < chunk_count_) memcpy(&header, base_ + directory_[chunk].offset, sizeof(header));
+    return header;
+}
+
+bool ArchiveReader::decodeChunk(size_t chunk, FrameColumns& out, uint32_t columns) const {
+    if(!base_ || chunk >= chunk_count_) return false;
+
+    const uint64_t offset = directory_[chunk].offset;
+    const ChunkHeader header = chunkHeader(chunk);
+    uint64_t column_total = 0;
+    for(uint32_t c = 0; c < COLUMN_COUNT; c++) column_total += header.column_bytes[c];
+    if(header.frame_count > chunk_frames_ || column_total != header.payload_bytes ||
+       offset + sizeof(ChunkHeader) + header.payload_bytes > chunks_end_) {
+        return false;
+    }
+
+    // The other corners are stored relative to FL
+    if(columns & (columnBit(TIRE_TEMP_FR) | columnBit(TIRE_TEMP_RL) | columnBit(TIRE_TEMP_RR))) {
+        columns |= columnBit(TIRE_TEMP_FL);
+    }
+
+    const size_t n = header.frame_count;
+    out.resize(n);
+    const uint8_t* p = base_ + offset + sizeof(ChunkHeader);
+    for(uint32_t c = 0; c < COLUMN_COUNT; c++) {
+        const uint8_t* data = p;
+        const size_t size = header.column_bytes[c];
+        const ColumnCodec::Codec codec = header.codec[c];
+        p += size;
+        if(!(columns & (1u << c))) continue;
+
+        bool ok = false;
+        switch(static_cast<Column>(c)) {
+            case ROW: ok = ColumnCodec::decodeIntegers(codec, data, size, out.row.data(), n); break;
+            case TIMESTAMP: ok = ColumnCodec::decodeIntegers(codec, data, size, out.timestamp_ns.data(), n); break;
+            case DRIVER_ID: ok = ColumnCodec::decodeIntegers(codec, data, size, out.driver_id.data(), n); break;
+            case LAP: ok = ColumnCodec::decodeIntegers(codec, data, size, out.lap.data(), n); break;
+            case SECTOR: ok = ColumnCodec::decodeIntegers(codec, data, size, out.sector.data(), n); break;
+            case RACE_POSITION: ok = ColumnCodec::decodeIntegers(codec, data, size, out.race_position.data(), n); break;
+            case SPEED: ok = ColumnCodec::decodeFloats(codec, data, size, nullptr, out.speed_kph.data(), n); break;
+            case THROTTLE: ok = ColumnCodec::decodeFloats(codec, data, size, nullptr, out.throttle.data(), n); break;
+            case BRAKE: ok = ColumnCodec::decodeFloats(codec, data, size, nullptr, out.brake.data(), n); break;
+            case TIRE_WEAR: ok = ColumnCodec::decodeFloats(codec, data, size, nullptr, out.tire_wear.data(), n); break;
+            case TIRE_TEMP_FL:
+                ok = ColumnCodec::decodeFloats(codec, data, size, nullptr, out.tire_temp_c[0].data(), n);
+                break;
+            case TIRE_TEMP_FR:
+            case TIRE_TEMP_RL:
+            case TIRE_TEMP_RR:
+                ok = ColumnCodec::decodeFloats(codec, data, size, out.tire_temp_c[0].data(),
+                                               out.tire_temp_c[c - TIRE_TEMP_FL].data(), n);
+                break;
+            case COLUMN_COUNT: break;
+        }
+        if(!ok) return false;
+    }
+
+    // toFrames() scatters by row, so it has to stay inside the chunk
+    if(columns & columnBit(ROW)) {
+        for(size_t i = 0; i < n; i++) {
+            if(out.row[i] >= n) return false;
+        }
+    }
+    return true;
+}
+
+bool ArchiveReader::next(FrameColumns& out, uint32_t columns) {
+    if(cursor_ >= chunk_count_ || !decodeChunk(cursor_, out, columns)) return false;
+    cursor_++;
+    return true;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "TelemetryArchive.h"
+#include "FrameColumns.h"
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// Reads a TelemetryArchive through a read-only mapping.
+//
+// next() streams chunks in order into a reused FrameColumns; decodeChunk() decodes
+// any chunk on its own and is safe to call from several threads at once, each with
+// its own FrameColumns. Both can skip columns the caller doesn't need: those are
+// sized but left as they were, and their bytes in the mapping are never read.
+class ArchiveReader {
+public:
+    explicit ArchiveReader(const std::string& path);
+    ~ArchiveReader();
+
+    ArchiveReader(const ArchiveReader&) = delete;
+    ArchiveReader& operator=(const ArchiveReader&) = delete;
+
+    // False if the file is missing, truncated or another format version.
+    bool isOpen() const { return base_ != nullptr; }
+
+    uint32_t driverCount() const { return driver_count_; }
+    uint64_t frameCount() const { return frame_count_; }
+    size_t chunkCount() const { return chunk_count_; }
+    size_t fileBytes() const { return mapping_size_; }
+
+    // Frame count, lap and time range of a chunk, without decoding it.
+    TelemetryArchive::ChunkHeader chunkHeader(size_t chunk) const;
+
+    // columns is a mask of TelemetryArchive::columnBit()s; ROW is needed for
+    // FrameColumns::toFrames() and FR/RL/RR decode FL too. False if the chunk is
+    // corrupt.
+    bool decodeChunk(size_t chunk, FrameColumns& out, uint32_t columns = TelemetryArchive::ALL_COLUMNS) const;
+
+    // The next chunk in file order; false after the last one (or on a corrupt chunk).
+    bool next(FrameColumns& out, uint32_t columns = TelemetryArchive::ALL_COLUMNS);
+    void rewind() { cursor_ = 0; }
+
+private:
+    void* mapping_;
+    size_t mapping_size_;
+    const uint8_t* base_;
+    uint64_t chunks_end_;   // where the directory starts
+    std::vector<TelemetryArchive::ChunkEntry> directory_;
+    size_t chunk_count_;
+    uint64_t frame_count_;
+    uint32_t driver_count_;
+    uint32_t chunk_frames_;
+    size_t cursor_;   // next chunk for next()
+};
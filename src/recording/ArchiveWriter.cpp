@@ -0,0 +1,194 @@
+#include "ArchiveWriter.h"
+#include <cstring>
+#include <numeric>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace TelemetryArchive;
+using ColumnCodec::Codec;
+
+ColumnCodec::Codec ArchiveWriter::codecFor(Column column) {
+    switch(column) {
+        // Constant steps within each driver's series
+        case ROW:
+        case TIMESTAMP:
+            return Codec::DELTA_OF_DELTA_RLE;
+        // Long runs within each driver's series
+        case DRIVER_ID:
+        case LAP:
+        case SECTOR:
+        case RACE_POSITION:
+            return Codec::RLE;
+        // All four corners share one temperature model, so FL predicts the others
+        case TIRE_TEMP_FR:
+        case TIRE_TEMP_RL:
+        case TIRE_TEMP_RR:
+            return Codec::XOR_REFERENCE;
+        // Smooth series; writeChunk() falls back to XOR for any chunk where it's smaller
+        default:
+            return Codec::XOR_LINEAR;
+    }
+}
+
+ArchiveWriter::ArchiveWriter(const string& path, uint32_t driver_count)
+    : path_(path), tmp_path_(path + ".tmp"), fd_(-1), offset_(0), failed_(false), stats_{} {
+    fd_ = open(tmp_path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(fd_ < 0) return;
+
+    ArchiveHeader header{};
+    memcpy(header.magic, MAGIC, sizeof(header.magic));
+    header.format_version = FORMAT_VERSION;
+    header.driver_count = driver_count;
+    header.chunk_frames = CHUNK_FRAMES;
+    writeAll(&header, sizeof(header));
+
+    pending_.reserve(CHUNK_FRAMES);
+}
+
+ArchiveWriter::~ArchiveWriter() {
+    finish();
+}
+
+bool ArchiveWriter::writeAll(const void* data, size_t n) {
+    const char* p = static_cast<const char*>(data);
+    while(n > 0 && !failed_) {
+        ssize_t written = write(fd_, p, n);
+        if(written <= 0) {
+            failed_ = true;
+            break;
+        }
+        p += written;
+        n -= static_cast<size_t>(written);
+        offset_ += static_cast<uint64_t>(written);
+    }
+    return !failed_;
+}
+
+bool ArchiveWriter::append(const TelemetryFrame* frames, size_t count) {
+    if(fd_ < 0 || failed_) return false;
+    while(count > 0) {
+        const size_t take = min(count, CHUNK_FRAMES - pending_.size());
+        pending_.insert(pending_.end(), frames, frames + take);
+        frames += take;
+        count -= take;
+        if(pending_.size() == CHUNK_FRAMES && !writeChunk()) return false;
+    }
+    return true;
+}
+
+bool ArchiveWriter::writeChunk() {
+    const size_t n = pending_.size();
+    if(n == 0) return true;
+
+    // Group rows by driver, keeping each driver's frames in time order
+    order_.resize(n);
+    iota(order_.begin(), order_.end(), 0u);
+    stable_sort(order_.begin(), order_.end(), [&](uint32_t a, uint32_t b) {
+        return pending_[a].driver_id < pending_[b].driver_id;
+    });
+
+    ChunkHeader header{};
+    header.frame_count = static_cast<uint32_t>(n);
+    header.min_timestamp_ns = UINT64_MAX;
+    header.min_lap = UINT32_MAX;
+
+    columns_.resize(n);
+    for(size_t i = 0; i < n; i++) {
+        const TelemetryFrame& f = pending_[order_[i]];
+        columns_.row[i] = order_[i];
+        columns_.timestamp_ns[i] = f.timestamp_ns;
+        columns_.driver_id[i] = f.driver_id;
+        columns_.lap[i] = f.lap;
+        columns_.sector[i] = f.sector;
+        columns_.race_position[i] = f.race_position;
+        columns_.speed_kph[i] = f.speed_kph;
+        columns_.throttle[i] = f.throttle;
+        columns_.brake[i] = f.brake;
+        columns_.tire_wear[i] = f.tire_wear;
+        for(int t = 0; t < 4; t++) columns_.tire_temp_c[t][i] = f.tire_temp_c[t];
+
+        header.min_timestamp_ns = min(header.min_timestamp_ns, f.timestamp_ns);
+        header.max_timestamp_ns = max(header.max_timestamp_ns, f.timestamp_ns);
+        header.min_lap = min(header.min_lap, f.lap);
+        header.max_lap = max(header.max_lap, f.lap);
+    }
+
+    payload_.clear();
+    for(uint32_t c = 0; c < COLUMN_COUNT; c++) {
+        const Column column = static_cast<Column>(c);
+        Codec codec = codecFor(column);
+        const size_t before = payload_.size();
+
+        // Flat stretches (throttle, brake, pit stops) cost more extrapolated than
+        // repeated, so a linear column is also tried plain and the smaller one kept
+        auto floats = [&](const float* values) {
+            ColumnCodec::encodeFloats(codec, values, nullptr, n, payload_);
+            if(codec != Codec::XOR_LINEAR) return;
+            scratch_.clear();
+            ColumnCodec::encodeFloats(Codec::XOR, values, nullptr, n, scratch_);
+            if(scratch_.size() < payload_.size() - before) {
+                payload_.resize(before);
+                payload_.insert(payload_.end(), scratch_.begin(), scratch_.end());
+                codec = Codec::XOR;
+            }
+        };
+
+        switch(column) {
+            case ROW: ColumnCodec::encodeIntegers(codec, columns_.row.data(), n, payload_); break;
+            case TIMESTAMP: ColumnCodec::encodeIntegers(codec, columns_.timestamp_ns.data(), n, payload_); break;
+            case DRIVER_ID: ColumnCodec::encodeIntegers(codec, columns_.driver_id.data(), n, payload_); break;
+            case LAP: ColumnCodec::encodeIntegers(codec, columns_.lap.data(), n, payload_); break;
+            case SECTOR: ColumnCodec::encodeIntegers(codec, columns_.sector.data(), n, payload_); break;
+            case RACE_POSITION: ColumnCodec::encodeIntegers(codec, columns_.race_position.data(), n, payload_); break;
+            case SPEED: floats(columns_.speed_kph.data()); break;
+            case THROTTLE: floats(columns_.throttle.data()); break;
+            case BRAKE: floats(columns_.brake.data()); break;
+            case TIRE_WEAR: floats(columns_.tire_wear.data()); break;
+            case TIRE_TEMP_FL: floats(columns_.tire_temp_c[0].data()); break;
+            case TIRE_TEMP_FR:
+            case TIRE_TEMP_RL:
+            case TIRE_TEMP_RR:
+                ColumnCodec::encodeFloats(codec, columns_.tire_temp_c[c - TIRE_TEMP_FL].data(),
+                                          columns_.tire_temp_c[0].data(), n, payload_);
+                break;
+            case COLUMN_COUNT: break;
+        }
+        header.codec[c] = codec;
+        header.column_bytes[c] = static_cast<uint32_t>(payload_.size() - before);
+        stats_.column_bytes[c] += header.column_bytes[c];
+    }
+    header.payload_bytes = static_cast<uint32_t>(payload_.size());
+
+    directory_.push_back({offset_, stats_.frames});
+    pending_.clear();
+    stats_.frames += n;
+    stats_.chunks++;
+    stats_.raw_bytes = stats_.frames * sizeof(TelemetryFrame);
+    return writeAll(&header, sizeof(header)) && writeAll(payload_.data(), payload_.size());
+}
+
+bool ArchiveWriter::finish() {
+    if(fd_ < 0) return false;
+
+    bool ok = writeChunk();
+    ArchiveFooter footer{};
+    footer.chunk_count = directory_.size();
+    footer.frame_count = stats_.frames;
+    footer.directory_offset = offset_;
+    memcpy(footer.magic, MAGIC, sizeof(footer.magic));
+    footer.format_version = FORMAT_VERSION;
+    ok = ok && writeAll(directory_.data(), directory_.size() * sizeof(ChunkEntry)) &&
+         writeAll(&footer, sizeof(footer));
+
+    ok = close(fd_) == 0 && ok;
+    fd_ = -1;
+    if(!ok || rename(tmp_path_.c_str(), path_.c_str()) != 0) {
+        unlink(tmp_path_.c_str());
+        failed_ = true;
+        return false;
+    }
+    stats_.archive_bytes = offset_;
+    return true;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "TelemetryArchive.h"
+#include "FrameColumns.h"
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// Streams frames into a TelemetryArchive file.
+//
+// Frames are buffered until a chunk is full, then regrouped by driver, encoded
+// column by column and written with one write(); memory is one chunk of frames plus
+// its encoding, whatever the length of the input. The archive appears at path only
+// once finish() succeeds (it's written to a temporary and renamed).
+class ArchiveWriter {
+public:
+    struct Stats {
+        uint64_t frames;
+        uint64_t chunks;
+        uint64_t raw_bytes;                                     // frames * sizeof(TelemetryFrame)
+        uint64_t archive_bytes;
+        uint64_t column_bytes[TelemetryArchive::COLUMN_COUNT];  // encoded, all chunks
+    };
+
+    ArchiveWriter(const std::string& path, uint32_t driver_count);
+    ~ArchiveWriter();
+
+    ArchiveWriter(const ArchiveWriter&) = delete;
+    ArchiveWriter& operator=(const ArchiveWriter&) = delete;
+
+    // False if the temporary file couldn't be created.
+    bool isOpen() const { return fd_ >= 0; }
+
+    bool append(const TelemetryFrame* frames, size_t count);
+
+    // Writes the last chunk and the directory and moves the archive into place.
+    // Returns false on any write error; the partial file is removed.
+    bool finish();
+
+    Stats stats() const { return stats_; }
+
+    // Codec each column is written with by default.
+    static ColumnCodec::Codec codecFor(TelemetryArchive::Column column);
+
+private:
+    bool writeChunk();
+    bool writeAll(const void* data, size_t n);
+
+    std::string path_;
+    std::string tmp_path_;
+    int fd_;
+    uint64_t offset_;
+    bool failed_;
+
+    std::vector<TelemetryFrame> pending_;
+    std::vector<uint32_t> order_;
+    FrameColumns columns_;
+    std::vector<uint8_t> payload_;
+    std::vector<uint8_t> scratch_;
+    std::vector<TelemetryArchive::ChunkEntry> directory_;
+    Stats stats_;
+};
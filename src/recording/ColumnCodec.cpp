@@ -0,0 +1,296 @@
+#include "ColumnCodec.h"
+#include <cstring>
+#include <algorithm>
+
+using namespace std;
+using ColumnCodec::Codec;
+
+namespace {
+    uint64_t zigzag(uint64_t v) {
+        return (v << 1) ^ static_cast<uint64_t>(static_cast<int64_t>(v) >> 63);
+    }
+
+    uint64_t unzigzag(uint64_t v) {
+        return (v >> 1) ^ (~(v & 1) + 1);
+    }
+
+    void writeVarint(uint64_t v, vector<uint8_t>& out) {
+        while(v >= 0x80) {
+            out.push_back(static_cast<uint8_t>(v | 0x80));
+            v >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(v));
+    }
+
+    bool readVarint(const uint8_t*& p, const uint8_t* end, uint64_t& v) {
+        v = 0;
+        for(int shift = 0; shift < 64 && p < end; shift += 7) {
+            const uint8_t byte = *p++;
+            v |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if(!(byte & 0x80)) return true;
+        }
+        return false;
+    }
+
+    uint32_t floatBits(float v) {
+        uint32_t bits;
+        memcpy(&bits, &v, sizeof(bits));
+        return bits;
+    }
+
+    float bitsFloat(uint32_t bits) {
+        float v;
+        memcpy(&v, &bits, sizeof(v));
+        return v;
+    }
+
+    // MSB-first bit packing
+    class BitWriter {
+    public:
+        explicit BitWriter(vector<uint8_t>& out) : out_(out), acc_(0), bits_(0) {}
+
+        // n <= 32
+        void put(uint32_t value, int n) {
+            acc_ = (acc_ << n) | value;
+            bits_ += n;
+            while(bits_ >= 8) {
+                bits_ -= 8;
+                out_.push_back(static_cast<uint8_t>(acc_ >> bits_));
+            }
+        }
+
+        void flush() {
+            if(bits_ > 0) out_.push_back(static_cast<uint8_t>(acc_ << (8 - bits_)));
+            bits_ = 0;
+        }
+
+    private:
+        vector<uint8_t>& out_;
+        uint64_t acc_;   // the low bits_ bits are pending
+        int bits_;
+    };
+
+    // The 64 bits starting at bit pos of data, MSB first. The low (pos % 8) bits
+    // are zero fill, so at least 57 are real; 8 bytes at pos / 8 must be readable.
+    uint64_t bitWindow(const uint8_t* data, uint64_t pos) {
+        uint64_t word;
+        memcpy(&word, data + (pos >> 3), sizeof(word));
+        return __builtin_bswap64(word) << (pos & 7);
+    }
+
+    template<Codec CODEC>
+    uint32_t predict(uint32_t prev, uint32_t prev2, const float* reference, size_t i) {
+        if constexpr(CODEC == Codec::XOR_REFERENCE) return floatBits(reference[i]);
+        if constexpr(CODEC == Codec::XOR_LINEAR) return 2 * prev - prev2;
+        return prev;
+    }
+
+    // Each value is decoded from one 64-bit window load, so the only state carried
+    // between values is the bit position and the window; the unpredictable choice
+    // between a zero XOR and a windowed one is made without a branch.
+    template<Codec CODEC>
+    bool decodeXor(const uint8_t* data, size_t size, const float* reference, float* values, size_t n) {
+        // The last few bytes are read from a zero-padded copy so no load runs past the data
+        uint8_t tail[16] = {};
+        const uint8_t* buffer = data;
+        uint64_t buffer_start = 0;   // bit offset of buffer within data
+
+        uint64_t pos = 0;
+        uint32_t prev = 0;
+        uint32_t prev2 = 0;
+        int length = 0;   // 0 = no window yet
+        int trail = 0;
+        uint32_t malformed = 0;
+
+        size_t i = 0;
+        while(i < n) {
+            if(buffer == data && (pos >> 3) + sizeof(uint64_t) > size) {
+                const size_t from = min<size_t>(pos >> 3, size);
+                memcpy(tail, data + from, size - from);
+                buffer = tail;
+                buffer_start = from * 8;
+            }
+            if(buffer == tail && ((pos - buffer_start) >> 3) + sizeof(uint64_t) > sizeof(tail)) return false;
+            const uint64_t w = bitWindow(buffer, pos - buffer_start);
+
+            // A long run of zero XORs (flat stretches, matching reference columns):
+            // every value in it is exactly its prediction
+            const size_t zeros = min<size_t>(w ? __builtin_clzll(w) : 64, 56);
+            if(zeros >= 16) {
+                const size_t run = min(zeros, n - i);
+                pos += run;
+                for(const size_t end = i + run; i < end; i++) {
+                    const uint32_t v = predict<CODEC>(prev, prev2, reference, i);
+                    prev2 = prev;
+                    prev = v;
+                    values[i] = bitsFloat(v);
+                }
+                continue;
+            }
+
+            uint32_t x;
+            if((w >> 62) == 0b11) {
+                // New window: 5 bits of leading zeros, 5 of length - 1, then the bits
+                const int lead = static_cast<int>((w >> 57) & 31);
+                length = static_cast<int>((w >> 52) & 31) + 1;
+                if(lead + length > 32) return false;
+                trail = 32 - lead - length;
+                x = static_cast<uint32_t>((w << 12) >> (64 - length)) << trail;
+                pos += 12 + length;
+            } else {
+                // 0: a zero XOR in one bit; 10: the bits inside the current window
+                const uint32_t windowed = static_cast<uint32_t>(w >> 63);
+                malformed |= windowed & (length == 0);
+                const uint32_t in_window = static_cast<uint32_t>(((w << 2) >> 1) >> (63 - length));
+                x = (in_window << trail) & (0u - windowed);
+                pos += 1 + windowed * (1 + length);
+            }
+            const uint32_t v = predict<CODEC>(prev, prev2, reference, i) ^ x;
+            prev2 = prev;
+            prev = v;
+            values[i++] = bitsFloat(v);
+        }
+        return !malformed && pos <= static_cast<uint64_t>(size) * 8;
+    }
+}
+
+namespace ColumnCodec {
+
+template<typename T>
+void encodeIntegers(Codec codec, const T* values, size_t n, vector<uint8_t>& out) {
+    uint64_t prev = 0;
+    uint64_t prev_delta = 0;
+    uint64_t run_value = 0;
+    uint64_t run = 0;
+
+    for(size_t i = 0; i < n; i++) {
+        const uint64_t v = values[i];
+        uint64_t x = v;
+        if(codec == Codec::DELTA_RLE) {
+            x = v - prev;
+        } else if(codec == Codec::DELTA_OF_DELTA_RLE) {
+            const uint64_t delta = v - prev;
+            x = delta - prev_delta;
+            prev_delta = delta;
+        }
+        prev = v;
+
+        if(run > 0 && x == run_value) {
+            run++;
+            continue;
+        }
+        if(run > 0) {
+            writeVarint(zigzag(run_value), out);
+            writeVarint(run, out);
+        }
+        run_value = x;
+        run = 1;
+    }
+    if(run > 0) {
+        writeVarint(zigzag(run_value), out);
+        writeVarint(run, out);
+    }
+}
+
+template<typename T>
+bool decodeIntegers(Codec codec, const uint8_t* data, size_t size, T* values, size_t n) {
+    const uint8_t* p = data;
+    const uint8_t* end = data + size;
+    uint64_t prev = 0;
+    uint64_t delta = 0;
+
+    size_t i = 0;
+    while(i < n) {
+        uint64_t zz, run;
+        if(!readVarint(p, end, zz) || !readVarint(p, end, run) || run == 0 || run > n - i) return false;
+        const uint64_t x = unzigzag(zz);
+        T* out = values + i;
+
+        switch(codec) {
+            case Codec::RLE:
+                fill(out, out + run, static_cast<T>(x));
+                break;
+            case Codec::DELTA_RLE:
+                for(uint64_t k = 0; k < run; k++) out[k] = static_cast<T>(prev + (k + 1) * x);
+                prev += run * x;
+                break;
+            case Codec::DELTA_OF_DELTA_RLE:
+                if(x == 0) {
+                    // Constant step, the common case: no dependency between rows
+                    for(uint64_t k = 0; k < run; k++) out[k] = static_cast<T>(prev + (k + 1) * delta);
+                    prev += run * delta;
+                    break;
+                }
+                for(uint64_t k = 0; k < run; k++) {
+                    delta += x;
+                    prev += delta;
+                    out[k] = static_cast<T>(prev);
+                }
+                break;
+            default:
+                return false;
+        }
+        i += run;
+    }
+    return p == end;
+}
+
+void encodeFloats(Codec codec, const float* values, const float* reference, size_t n, vector<uint8_t>& out) {
+    BitWriter bits(out);
+    uint32_t prev = 0;
+    uint32_t prev2 = 0;
+    int window_lead = -1;   // no window yet
+    int window_trail = 0;
+
+    for(size_t i = 0; i < n; i++) {
+        const uint32_t v = floatBits(values[i]);
+        uint32_t prediction = prev;
+        if(codec == Codec::XOR_REFERENCE) prediction = floatBits(reference[i]);
+        if(codec == Codec::XOR_LINEAR) prediction = 2 * prev - prev2;
+        const uint32_t x = v ^ prediction;
+        prev2 = prev;
+        prev = v;
+
+        if(x == 0) {
+            bits.put(0, 1);
+            continue;
+        }
+        // Reuse the window while it costs no more than a new 10-bit header would
+        const int lead = __builtin_clz(x);
+        const int trail = __builtin_ctz(x);
+        const int window_length = 32 - window_lead - window_trail;
+        if(window_lead >= 0 && lead >= window_lead && trail >= window_trail &&
+           window_length <= 10 + (32 - lead - trail)) {
+            bits.put(0b10, 2);
+            bits.put(x >> window_trail, 32 - window_lead - window_trail);
+        } else {
+            const int length = 32 - lead - trail;
+            bits.put(0b11, 2);
+            bits.put(static_cast<uint32_t>(lead), 5);
+            bits.put(static_cast<uint32_t>(length - 1), 5);
+            bits.put(x >> trail, length);
+            window_lead = lead;
+            window_trail = trail;
+        }
+    }
+    bits.flush();
+}
+
+bool decodeFloats(Codec codec, const uint8_t* data, size_t size, const float* reference, float* values, size_t n) {
+    switch(codec) {
+        case Codec::XOR: return decodeXor<Codec::XOR>(data, size, reference, values, n);
+        case Codec::XOR_LINEAR: return decodeXor<Codec::XOR_LINEAR>(data, size, reference, values, n);
+        case Codec::XOR_REFERENCE:
+            return reference && decodeXor<Codec::XOR_REFERENCE>(data, size, reference, values, n);
+        default: return false;
+    }
+}
+
+template void encodeIntegers<uint8_t>(Codec, const uint8_t*, size_t, vector<uint8_t>&);
+template void encodeIntegers<uint32_t>(Codec, const uint32_t*, size_t, vector<uint8_t>&);
+template void encodeIntegers<uint64_t>(Codec, const uint64_t*, size_t, vector<uint8_t>&);
+template bool decodeIntegers<uint8_t>(Codec, const uint8_t*, size_t, uint8_t*, size_t);
+template bool decodeIntegers<uint32_t>(Codec, const uint8_t*, size_t, uint32_t*, size_t);
+template bool decodeIntegers<uint64_t>(Codec, const uint8_t*, size_t, uint64_t*, size_t);
+
+}
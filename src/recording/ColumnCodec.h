@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Per-column encodings for the telemetry archive. Every codec is lossless.
+//
+// Integer codecs transform the column (raw, delta or delta-of-delta), zigzag the
+// result and store it as LEB128 (value, run length) pairs, so a constant column, a
+// constant step (driver order) and a constant rate (timestamps) each cost a few
+// bytes per chunk. Float codecs XOR each value with a prediction (the previous
+// value, a linear extrapolation of the previous two, or the same row of a reference
+// column) and pack the XOR Gorilla style: one bit when it's zero, otherwise the
+// meaningful bits inside a leading/trailing-zero window that's reused while it
+// fits. Extrapolating the bit patterns suits smoothly changing values; within one
+// exponent the bits move almost linearly, so far fewer of them differ.
+namespace ColumnCodec {
+
+    enum class Codec : uint8_t {
+        RLE = 0,
+        DELTA_RLE = 1,
+        DELTA_OF_DELTA_RLE = 2,
+        XOR = 3,             // floats, predicted by the previous value
+        XOR_REFERENCE = 4,   // floats, predicted by the reference column's value in the same row
+        XOR_LINEAR = 5,      // floats, predicted by extrapolating the previous two values' bits
+    };
+
+    // Appends the encoded column to out. T is uint8_t, uint32_t or uint64_t.
+    template<typename T>
+    void encodeIntegers(Codec codec, const T* values, size_t n, std::vector<uint8_t>& out);
+
+    // Decodes exactly n values. False if the data is malformed or doesn't hold n values.
+    template<typename T>
+    bool decodeIntegers(Codec codec, const uint8_t* data, size_t size, T* values, size_t n);
+
+    // reference is required for XOR_REFERENCE and ignored otherwise.
+    void encodeFloats(Codec codec, const float* values, const float* reference, size_t n, std::vector<uint8_t>& out);
+    bool decodeFloats(Codec codec, const uint8_t* data, size_t size, const float* reference, float* values, size_t n);
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "../common/types.h"
+
+// One archive chunk of telemetry, structure-of-arrays, as ArchiveReader decodes it.
+// Rows are grouped by driver (each driver's frames in time order, drivers in id
+// order) because that's how the archive stores them; row[i] gives frame i's
+// position in the chunk's original publish order. Reuse the same instance across
+// chunks: resize() doesn't allocate once it has seen a full-size chunk.
+struct FrameColumns {
+    std::vector<uint32_t> row;
+    std::vector<uint64_t> timestamp_ns;
+    std::vector<uint32_t> driver_id;
+    std::vector<uint32_t> lap;
+    std::vector<uint8_t>  sector;
+    std::vector<uint8_t>  race_position;
+
+    std::vector<float> speed_kph;
+    std::vector<float> throttle;
+    std::vector<float> brake;
+    std::vector<float> tire_wear;
+    std::vector<float> tire_temp_c[4];   // FL, FR, RL, RR
+
+    size_t size() const { return row.size(); }
+
+    void resize(size_t n) {
+        if (n == size()) return;
+        row.resize(n);
+        timestamp_ns.resize(n);
+        driver_id.resize(n);
+        lap.resize(n);
+        sector.resize(n);
+        race_position.resize(n);
+        speed_kph.resize(n);
+        throttle.resize(n);
+        brake.resize(n);
+        tire_wear.resize(n);
+        for (auto& temps : tire_temp_c) temps.resize(n);
+    }
+
+    TelemetryFrame frame(size_t i) const {
+        TelemetryFrame f{};
+        f.timestamp_ns = timestamp_ns[i];
+        f.driver_id = driver_id[i];
+        f.lap = lap[i];
+        f.sector = sector[i];
+        f.race_position = race_position[i];
+        f.speed_kph = speed_kph[i];
+        f.throttle = throttle[i];
+        f.brake = brake[i];
+        f.tire_wear = tire_wear[i];
+        for (int t = 0; t < 4; t++) f.tire_temp_c[t] = tire_temp_c[t][i];
+        return f;
+    }
+
+    // Frames back in publish order; reuses out's capacity.
+    void toFrames(std::vector<TelemetryFrame>& out) const {
+        out.resize(size());
+        for (size_t i = 0; i < size(); i++) out[row[i]] = frame(i);
+    }
+};
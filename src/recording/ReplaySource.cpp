@@ -0,0 +1,108 @@
+#include "ReplaySource.h"
+#include <cstring>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+namespace {
+    // Whole file, read-only; nullptr if it can't be mapped or is shorter than min_size.
+    void* mapFile(const string& path, size_t min_size, size_t& size) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if(fd < 0) return nullptr;
+
+        struct stat st;
+        if(fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < min_size) {
+            close(fd);
+            return nullptr;
+        }
+        size = static_cast<size_t>(st.st_size);
+
+        void* mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);   // the mapping keeps the file alive
+        return mapping == MAP_FAILED ? nullptr : mapping;
+    }
+}
+
+ReplaySource::ReplaySource(const string& path)
+    : log_mapping_(nullptr), log_size_(0), index_mapping_(nullptr), index_size_(0),
+      frames_(nullptr), frame_count_(0), index_(nullptr), index_count_(0), driver_count_(0), cursor_(0) {
+    log_mapping_ = mapFile(path, sizeof(TelemetryLog::LogHeader), log_size_);
+    if(!log_mapping_) return;
+
+    const auto* header = static_cast<const TelemetryLog::LogHeader*>(log_mapping_);
+    if(memcmp(header->magic, TelemetryLog::LOG_MAGIC, sizeof(header->magic)) != 0 ||
+       header->format_version != TelemetryLog::FORMAT_VERSION || header->frame_size != sizeof(TelemetryFrame)) {
+        munmap(log_mapping_, log_size_);
+        log_mapping_ = nullptr;
+        return;
+    }
+    madvise(log_mapping_, log_size_, MADV_SEQUENTIAL);
+
+    // A recorder that died mid-write leaves a partial frame at the end; ignore it
+    driver_count_ = header->driver_count;
+    frame_count_ = (log_size_ - sizeof(TelemetryLog::LogHeader)) / sizeof(TelemetryFrame);
+    frames_ = reinterpret_cast<const TelemetryFrame*>(static_cast<const char*>(log_mapping_) +
+                                                      sizeof(TelemetryLog::LogHeader));
+
+    index_mapping_ = mapFile(TelemetryLog::indexPath(path), sizeof(TelemetryLog::IndexHeader), index_size_);
+    if(!index_mapping_) return;
+
+    const auto* index_header = static_cast<const TelemetryLog::IndexHeader*>(index_mapping_);
+    if(memcmp(index_header->magic, TelemetryLog::INDEX_MAGIC, sizeof(index_header->magic)) != 0 ||
+       index_header->format_version != TelemetryLog::FORMAT_VERSION ||
+       index_size_ != sizeof(TelemetryLog::IndexHeader) + index_header->entry_count * sizeof(TelemetryLog::IndexEntry)) {
+        munmap(index_mapping_, index_size_);
+        index_mapping_ = nullptr;
+        return;
+    }
+    index_count_ = index_header->entry_count;
+    index_ = reinterpret_cast<const TelemetryLog::IndexEntry*>(static_cast<const char*>(index_mapping_) +
+                                                              sizeof(TelemetryLog::IndexHeader));
+}
+
+ReplaySource::~ReplaySource() {
+    if(log_mapping_) munmap(log_mapping_, log_size_);
+    if(index_mapping_) munmap(index_mapping_, index_size_);
+}
+
+uint64_t ReplaySource::framesDropped() const {
+    return index_ ? static_cast<const TelemetryLog::IndexHeader*>(index_mapping_)->frames_dropped : 0;
+}
+
+bool ReplaySource::seekToLap(uint32_t lap) {
+    if(!index_) return false;
+
+    // Entries are sorted by lap then driver; the lap starts at its leader's first frame
+    const TelemetryLog::IndexEntry* end = index_ + index_count_;
+    const TelemetryLog::IndexEntry* first = lower_bound(index_, end, lap,
+        [](const TelemetryLog::IndexEntry& entry, uint32_t l) { return entry.lap < l; });
+    if(first == end) return false;
+
+    uint64_t offset = UINT64_MAX;
+    for(const TelemetryLog::IndexEntry* e = first; e != end && e->lap == first->lap; e++) {
+        offset = min(offset, e->offset);
+    }
+    const uint64_t frame = (offset - sizeof(TelemetryLog::LogHeader)) / sizeof(TelemetryFrame);
+    if(offset < sizeof(TelemetryLog::LogHeader) || frame >= frame_count_) return false;
+
+    // Back up to the start of that tick so every driver is replayed from the same instant
+    cursor_ = frame;
+    while(cursor_ > 0 && frames_[cursor_ - 1].timestamp_ns == frames_[frame].timestamp_ns) cursor_--;
+    return true;
+}
+
+bool ReplaySource::nextTick(const TelemetryFrame*& frames, size_t& count) {
+    if(cursor_ >= frame_count_) return false;
+
+    const uint64_t begin = cursor_;
+    const uint64_t timestamp = frames_[begin].timestamp_ns;
+    while(cursor_ < frame_count_ && frames_[cursor_].timestamp_ns == timestamp) cursor_++;
+
+    frames = frames_ + begin;
+    count = static_cast<size_t>(cursor_ - begin);
+    return true;
+}
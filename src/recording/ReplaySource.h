@@ -0,0 +1,56 @@
+#pragma once
+
+#include "TelemetryLog.h"
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// Plays a TelemetryRecorder log back one tick at a time, in place of the
+// TelemetryGenerator as the bus producer.
+//
+// The log and its index are mapped read-only and ticks are handed out as pointers
+// into the mapping, so replay allocates nothing and copies a frame only when the
+// bus publishes it. A tick is a run of frames with the same timestamp, exactly as
+// they were published. Pacing is the caller's: replay reproduces the frames, not
+// their timing.
+class ReplaySource {
+public:
+    explicit ReplaySource(const std::string& path);
+    ~ReplaySource();
+
+    ReplaySource(const ReplaySource&) = delete;
+    ReplaySource& operator=(const ReplaySource&) = delete;
+
+    // False if the log is missing or was written by another format version or build.
+    bool isOpen() const { return frames_ != nullptr; }
+    // False if the index sidecar is missing or malformed; playback still works, seeking doesn't.
+    bool hasIndex() const { return index_ != nullptr; }
+
+    uint32_t driverCount() const { return driver_count_; }
+    uint64_t frameCount() const { return frame_count_; }
+    // Frames the recorder missed; 0 without an index.
+    uint64_t framesDropped() const;
+
+    // Moves to the first tick in which any driver is on lap (or the first later lap
+    // that was recorded). False, with the position unchanged, if there's no index or
+    // nothing at or after that lap.
+    bool seekToLap(uint32_t lap);
+    void rewind() { cursor_ = 0; }
+
+    // Points frames at the next tick; valid for the lifetime of the source. False at
+    // the end of the log, leaving frames and count as they were.
+    bool nextTick(const TelemetryFrame*& frames, size_t& count);
+
+private:
+    void* log_mapping_;
+    size_t log_size_;
+    void* index_mapping_;
+    size_t index_size_;
+
+    const TelemetryFrame* frames_;
+    uint64_t frame_count_;
+    const TelemetryLog::IndexEntry* index_;
+    uint64_t index_count_;
+    uint32_t driver_count_;
+    uint64_t cursor_;   // next frame to hand out
+};
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "ColumnCodec.h"
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// On-disk layout shared by ArchiveWriter and ArchiveReader: compressed, columnar
+// telemetry for long-term storage and analytics.
+//
+// An ArchiveHeader, then chunks of up to CHUNK_FRAMES consecutive frames, then a
+// chunk directory and an ArchiveFooter. Each chunk is a ChunkHeader followed by its
+// columns back to back, each encoded with the codec named in the header; within a
+// chunk, rows are grouped by driver so every column is a set of smooth per-driver
+// series. Chunks are self-contained, so they can be decoded in order while
+// streaming or independently (in parallel) through the directory, and the
+// per-chunk lap and time ranges let readers skip chunks without decoding them.
+namespace TelemetryArchive {
+
+    constexpr char MAGIC[4] = {'F', '1', 'T', 'A'};
+    constexpr uint32_t FORMAT_VERSION = 1;
+    constexpr uint32_t CHUNK_FRAMES = 16384;
+
+    enum Column : uint32_t {
+        ROW,              // position in the chunk's publish order
+        TIMESTAMP,
+        DRIVER_ID,
+        LAP,
+        SECTOR,
+        RACE_POSITION,
+        SPEED,
+        THROTTLE,
+        BRAKE,
+        TIRE_WEAR,
+        TIRE_TEMP_FL,
+        TIRE_TEMP_FR,
+        TIRE_TEMP_RL,
+        TIRE_TEMP_RR,
+        COLUMN_COUNT
+    };
+
+    constexpr uint32_t columnBit(Column column) { return 1u << column; }
+    constexpr uint32_t ALL_COLUMNS = (1u << COLUMN_COUNT) - 1;
+
+    inline const char* columnName(Column column) {
+        static const char* const NAMES[COLUMN_COUNT] = {
+            "row", "timestamp", "driver_id", "lap", "sector", "race_position", "speed", "throttle", "brake",
+            "tire_wear", "tire_temp_fl", "tire_temp_fr", "tire_temp_rl", "tire_temp_rr"};
+        return column < COLUMN_COUNT ? NAMES[column] : "";
+    }
+
+    // COLUMN_COUNT if name isn't a column.
+    inline Column columnByName(const std::string& name) {
+        for(uint32_t c = 0; c < COLUMN_COUNT; c++) {
+            if(name == columnName(static_cast<Column>(c))) return static_cast<Column>(c);
+        }
+        return COLUMN_COUNT;
+    }
+
+    struct ArchiveHeader {
+        char magic[4];
+        uint32_t format_version;
+        uint32_t driver_count;
+        uint32_t chunk_frames;
+    };
+
+    struct ChunkHeader {
+        uint32_t frame_count;
+        uint32_t payload_bytes;          // columns, after this header
+        uint64_t min_timestamp_ns;
+        uint64_t max_timestamp_ns;
+        uint32_t min_lap;
+        uint32_t max_lap;
+        uint32_t column_bytes[COLUMN_COUNT];
+        ColumnCodec::Codec codec[COLUMN_COUNT];
+        uint8_t reserved[2];
+    };
+    static_assert(sizeof(ChunkHeader) == 104, "ChunkHeader is part of the file format");
+
+    struct ChunkEntry {
+        uint64_t offset;                 // of the ChunkHeader
+        uint64_t first_frame;            // frames in all earlier chunks
+    };
+
+    struct ArchiveFooter {
+        uint64_t chunk_count;
+        uint64_t frame_count;
+        uint64_t directory_offset;
+        char magic[4];
+        uint32_t format_version;
+    };
+
+    inline std::string archivePath(const std::string& log_path) { return log_path + ".f1a"; }
+}
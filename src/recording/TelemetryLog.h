@@ -0,0 +1,45 @@
+#pragma once
+
+#include "../common/types.h"
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// On-disk layout shared by TelemetryRecorder (writer) and ReplaySource (reader).
+//
+// Log file: a LogHeader followed by raw TelemetryFrames in publish order, appended
+// until the race ends. Frames are stored exactly as they are in memory, so the
+// header pins the version and frame size and a reader rejects anything else.
+//
+// Index sidecar (<log>.idx): an IndexHeader followed by one IndexEntry per
+// (lap, driver_id), sorted by lap then driver, pointing at that driver's first
+// frame of the lap.
+namespace TelemetryLog {
+
+    constexpr char LOG_MAGIC[4] = {'F', '1', 'T', 'L'};
+    constexpr char INDEX_MAGIC[4] = {'F', '1', 'T', 'I'};
+    constexpr uint32_t FORMAT_VERSION = 1;
+
+    struct LogHeader {
+        char magic[4];
+        uint32_t format_version;
+        uint32_t frame_size;       // sizeof(TelemetryFrame) when written
+        uint32_t driver_count;
+    };
+
+    struct IndexHeader {
+        char magic[4];
+        uint32_t format_version;
+        uint64_t entry_count;
+        uint64_t frames_recorded;
+        uint64_t frames_dropped;   // lapped on the bus before the recorder read them
+    };
+
+    struct IndexEntry {
+        uint32_t lap;
+        uint32_t driver_id;
+        uint64_t offset;           // byte offset of the frame in the log
+    };
+
+    inline std::string indexPath(const std::string& log_path) { return log_path + ".idx"; }
+}
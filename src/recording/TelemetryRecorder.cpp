@@ -0,0 +1,181 @@
+#include "TelemetryRecorder.h"
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+    bool writeAll(int fd, const void* data, size_t n) {
+        const char* p = static_cast<const char*>(data);
+        while(n > 0) {
+            ssize_t written = write(fd, p, n);
+            if(written <= 0) return false;
+            p += written;
+            n -= static_cast<size_t>(written);
+        }
+        return true;
+    }
+
+    double millisecondsSince(chrono::steady_clock::time_point start) {
+        return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    }
+}
+
+TelemetryRecorder::TelemetryRecorder(const string& path, BroadcastBus<TelemetryFrame>& bus, uint32_t driver_count)
+    : path_(path), fd_(-1), feed_(bus.subscribe()), reader_done_(false),
+      last_lap_(driver_count, UINT32_MAX), frames_read_(0), reader_wait_ms_(0.0),
+      bytes_written_(0), writes_(0), write_ms_(0.0), write_failed_(false), finished_(false) {
+    fd_ = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(fd_ < 0) return;
+
+    TelemetryLog::LogHeader header{};
+    memcpy(header.magic, TelemetryLog::LOG_MAGIC, sizeof(header.magic));
+    header.format_version = TelemetryLog::FORMAT_VERSION;
+    header.frame_size = sizeof(TelemetryFrame);
+    header.driver_count = driver_count;
+    if(!writeAll(fd_, &header, sizeof(header))) {
+        close(fd_);
+        fd_ = -1;
+        return;
+    }
+    bytes_written_ = sizeof(header);
+
+    blocks_.resize(BLOCK_COUNT);
+    for(size_t b = 0; b < BLOCK_COUNT; b++) {
+        blocks_[b].frames.resize(BLOCK_FRAMES);
+        blocks_[b].count = 0;
+        free_blocks_.push_back(b);
+    }
+
+    reader_ = thread(&TelemetryRecorder::readLoop, this);
+    flusher_ = thread(&TelemetryRecorder::flushLoop, this);
+}
+
+TelemetryRecorder::~TelemetryRecorder() {
+    // The reader otherwise only stops when the bus shuts down
+    if(!finished_) feed_.cancel();
+    finish();
+}
+
+void TelemetryRecorder::readLoop() {
+    auto acquire = [&]() {
+        unique_lock<mutex> lock(mutex_);
+        if(free_blocks_.empty()) {
+            // Every block is queued for the disk; the bus keeps going without us
+            const auto wait_start = chrono::steady_clock::now();
+            cv_.wait(lock, [&]() { return !free_blocks_.empty(); });
+            reader_wait_ms_ += millisecondsSince(wait_start);
+        }
+        const size_t b = free_blocks_.back();
+        free_blocks_.pop_back();
+        blocks_[b].count = 0;
+        return b;
+    };
+    auto submit = [&](size_t b) {
+        lock_guard<mutex> lock(mutex_);
+        full_blocks_.push_back(b);
+        cv_.notify_all();
+    };
+
+    size_t current = acquire();
+    while(true) {
+        Block& block = blocks_[current];
+        if(block.count == BLOCK_FRAMES) {
+            submit(current);
+            current = acquire();
+            continue;
+        }
+
+        // Read straight into the block; the bus copies each frame exactly once
+        TelemetryFrame* out = block.frames.data() + block.count;
+        const size_t n = feed_.next(out, BLOCK_FRAMES - block.count);
+        if(n == 0) break;
+
+        for(size_t i = 0; i < n; i++) {
+            const TelemetryFrame& frame = out[i];
+            if(frame.driver_id < last_lap_.size() && frame.lap != last_lap_[frame.driver_id]) {
+                last_lap_[frame.driver_id] = frame.lap;
+                index_.push_back({frame.lap, frame.driver_id,
+                                  sizeof(TelemetryLog::LogHeader) + (frames_read_ + i) * sizeof(TelemetryFrame)});
+            }
+        }
+        block.count += n;
+        frames_read_ += n;
+    }
+
+    lock_guard<mutex> lock(mutex_);
+    if(blocks_[current].count > 0) {
+        full_blocks_.push_back(current);
+    } else {
+        free_blocks_.push_back(current);
+    }
+    reader_done_ = true;
+    cv_.notify_all();
+}
+
+void TelemetryRecorder::flushLoop() {
+    unique_lock<mutex> lock(mutex_);
+    while(true) {
+        cv_.wait(lock, [&]() { return !full_blocks_.empty() || reader_done_; });
+        if(full_blocks_.empty()) break;   // reader done and everything written
+
+        const size_t b = full_blocks_.front();
+        full_blocks_.erase(full_blocks_.begin());
+        lock.unlock();
+
+        const Block& block = blocks_[b];
+        const auto write_start = chrono::steady_clock::now();
+        if(!write_failed_) {
+            const size_t bytes = block.count * sizeof(TelemetryFrame);
+            write_failed_ = !writeAll(fd_, block.frames.data(), bytes);
+            if(!write_failed_) bytes_written_ += bytes;
+        }
+        write_ms_ += millisecondsSince(write_start);
+        writes_++;
+
+        lock.lock();
+        free_blocks_.push_back(b);
+        cv_.notify_all();
+    }
+}
+
+bool TelemetryRecorder::writeIndex() {
+    sort(index_.begin(), index_.end(), [](const TelemetryLog::IndexEntry& a, const TelemetryLog::IndexEntry& b) {
+        return a.lap != b.lap ? a.lap < b.lap : a.driver_id < b.driver_id;
+    });
+
+    TelemetryLog::IndexHeader header{};
+    memcpy(header.magic, TelemetryLog::INDEX_MAGIC, sizeof(header.magic));
+    header.format_version = TelemetryLog::FORMAT_VERSION;
+    header.entry_count = index_.size();
+    header.frames_recorded = frames_read_;
+    header.frames_dropped = feed_.lapped();
+
+    const string path = TelemetryLog::indexPath(path_);
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(fd < 0) return false;
+    bool ok = writeAll(fd, &header, sizeof(header)) &&
+              writeAll(fd, index_.data(), index_.size() * sizeof(TelemetryLog::IndexEntry));
+    return close(fd) == 0 && ok;
+}
+
+bool TelemetryRecorder::finish() {
+    if(fd_ < 0) return false;
+    if(finished_) return !write_failed_;
+    finished_ = true;
+
+    reader_.join();
+    flusher_.join();
+
+    const bool index_ok = writeIndex();
+    const bool close_ok = close(fd_) == 0;
+    write_failed_ = write_failed_ || !index_ok || !close_ok;
+    return !write_failed_;
+}
+
+TelemetryRecorder::Stats TelemetryRecorder::stats() const {
+    return {frames_read_, feed_.lapped(), bytes_written_, writes_, write_ms_, reader_wait_ms_};
+}
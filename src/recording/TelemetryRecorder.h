@@ -0,0 +1,93 @@
+#pragma once
+
+#include "TelemetryLog.h"
+#include "../ingestion/BroadcastBus.h"
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+
+// Bus subscriber that appends every frame to a TelemetryLog file.
+//
+// A reader thread drains the subscription into fixed-size blocks; a flush thread
+// writes full blocks with one large write() each. There are BLOCK_COUNT blocks in
+// total, so memory stays bounded however slow the disk is: if every block is
+// waiting on the disk the reader stops reading, and the bus laps the recorder (the
+// skipped frames are counted as dropped) rather than ever slowing the producer.
+//
+// Subscribe before the race starts; the recorder sees only frames published
+// afterwards. Call finish() after the bus is shut down to drain, flush and write
+// the (lap, driver) index sidecar. Destroying a recorder that wasn't finished
+// stops reading at once instead of waiting for the bus: what was already read is
+// still written and indexed.
+class TelemetryRecorder {
+public:
+    static constexpr size_t BLOCK_FRAMES = 16384;   // ~900 KB per write
+    static constexpr size_t BLOCK_COUNT = 4;
+
+    struct Stats {
+        uint64_t frames;          // written to the log
+        uint64_t dropped;         // lapped on the bus
+        uint64_t bytes;
+        uint64_t writes;
+        double write_ms;          // time the flush thread spent in write()
+        double reader_wait_ms;    // time the reader spent waiting for a free block
+    };
+
+    TelemetryRecorder(const std::string& path, BroadcastBus<TelemetryFrame>& bus, uint32_t driver_count);
+    ~TelemetryRecorder();
+
+    TelemetryRecorder(const TelemetryRecorder&) = delete;
+    TelemetryRecorder& operator=(const TelemetryRecorder&) = delete;
+
+    // False if the log couldn't be created; nothing is recorded then.
+    bool isOpen() const { return fd_ >= 0; }
+    const std::string& path() const { return path_; }
+
+    // Blocks until everything published before bus shutdown is on disk and the
+    // index is written. Returns false on any write error.
+    bool finish();
+
+    // Complete once finish() has returned.
+    Stats stats() const;
+
+private:
+    struct Block {
+        std::vector<TelemetryFrame> frames;
+        size_t count;
+    };
+
+    void readLoop();
+    void flushLoop();
+    bool writeIndex();
+
+    std::string path_;
+    int fd_;
+    BroadcastBus<TelemetryFrame>::Subscriber feed_;
+
+    std::vector<Block> blocks_;
+    std::vector<size_t> free_blocks_;    // guarded by mutex_
+    std::vector<size_t> full_blocks_;    // FIFO, guarded by mutex_
+    bool reader_done_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+
+    // Owned by the reader thread until it exits
+    std::vector<TelemetryLog::IndexEntry> index_;
+    std::vector<uint32_t> last_lap_;
+    uint64_t frames_read_;
+    double reader_wait_ms_;
+
+    // Owned by the flush thread until it exits
+    uint64_t bytes_written_;
+    uint64_t writes_;
+    double write_ms_;
+    bool write_failed_;
+
+    std::thread reader_;
+    std::thread flusher_;
+    bool finished_;
+};
@@ -0,0 +1,49 @@
+#include "LiveStrategyOptimizer.h"
+
+using namespace std;
+
+LiveStrategyOptimizer::LiveStrategyOptimizer(const RaceSimulator& simulator, chrono::microseconds budget)
+    : simulator_(simulator), budget_(budget) {}
+
+ReplanReport LiveStrategyOptimizer::reoptimize(const RaceSnapshot& snapshot, const map<uint32_t, uint32_t>& current_plan) const {
+    const auto start = chrono::steady_clock::now();
+    const auto deadline = start + budget_;
+    ReplanReport report{{}, 0, 0.0};
+
+    vector<uint32_t> laps;
+    for(const auto& entry : current_plan) {
+        const uint32_t driver_id = entry.first;
+        if(driver_id >= snapshot.states.size()) continue;
+
+        const DriverState& live = snapshot.states[driver_id];
+        // The generator executes one planned stop; once it's taken there is nothing to re-plan.
+        if(live.has_pitted || live.is_on_pit) continue;
+
+        if(chrono::steady_clock::now() >= deadline) {
+            report.skipped++;
+            continue;
+        }
+
+        laps.clear();
+        for(uint32_t lap = live.lap; lap < simulator_.totalLaps(); lap++) laps.push_back(lap);
+        if(laps.empty()) continue;
+
+        const RaceSimulator::DriverSnapshot from = simulator_.snapshotFromLive(live, snapshot.timestamp_ns);
+        const vector<float> times = simulator_.simulatePitCandidates(driver_id, from, laps);
+
+        size_t best = 0;
+        for(size_t i = 1; i < times.size(); i++) {
+            if(times[i] < times[best]) best = i;
+        }
+
+        const uint32_t planned_lap = entry.second;
+        if(planned_lap >= live.lap && planned_lap < simulator_.totalLaps()) {
+            const size_t planned = planned_lap - live.lap;
+            if(times[best] > times[planned] - MIN_GAIN_SECONDS) best = planned;
+        }
+        report.plans.push_back({driver_id, laps[best], times[best]});
+    }
+
+    report.elapsed_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    return report;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "RaceSimulator.h"
+#include <vector>
+#include <map>
+#include <chrono>
+#include <cstdint>
+
+struct LiveReplan {
+    uint32_t driver_id;
+    uint32_t pit_lap;
+    float remaining_seconds;   // predicted time from the snapshot to the flag
+};
+
+struct ReplanReport {
+    std::vector<LiveReplan> plans;
+    uint32_t skipped;          // drivers left on their old plan because the budget ran out
+    double elapsed_ms;
+};
+
+// Re-plans the remaining race for drivers that still have a planned stop ahead,
+// starting from a RaceSnapshot of the live generator instead of the grid, so
+// penalties served in the pits and wear that diverged from the pre-race plan
+// are accounted for. Every lap from the driver's current one to the last is a
+// candidate (one forked pass per driver). Drivers are handled one at a time and
+// the budget is checked before each: anything not reached keeps its plan.
+class LiveStrategyOptimizer {
+public:
+    static constexpr std::chrono::milliseconds DEFAULT_BUDGET{100};
+    // A new lap must beat the current plan by more than the model's own error to replace it,
+    // so near-ties don't flip the plan lap to lap.
+    static constexpr float MIN_GAIN_SECONDS = RaceSimulator::EVENT_TOLERANCE_SECONDS;
+
+    explicit LiveStrategyOptimizer(const RaceSimulator& simulator,
+                                   std::chrono::microseconds budget = DEFAULT_BUDGET);
+
+    ReplanReport reoptimize(const RaceSnapshot& snapshot, const std::map<uint32_t, uint32_t>& current_plan) const;
+
+    std::chrono::microseconds budget() const { return budget_; }
+
+private:
+    const RaceSimulator& simulator_;
+    std::chrono::microseconds budget_;
+};
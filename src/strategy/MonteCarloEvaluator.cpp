@@ -0,0 +1,160 @@
+#include "MonteCarloEvaluator.h"
+#include "../common/CounterRng.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+namespace {
+    // Independent draw streams within a trial
+    enum DrawKind : uint64_t { SAFETY_CAR = 1, LAP_NOISE = 2, TRAFFIC = 3 };
+
+    uint64_t trialStream(uint32_t driver_id, uint32_t trial, DrawKind kind) {
+        return (static_cast<uint64_t>(driver_id) << 48) | (static_cast<uint64_t>(kind) << 40) | trial;
+    }
+}
+
+MonteCarloEvaluator::MonteCarloEvaluator(const RaceSimulator& simulator, WorkStealingPool& pool)
+    : simulator_(simulator), model_(*simulator.model()), pool_(pool) {}
+
+void MonteCarloEvaluator::runTrial(uint32_t driver_id, uint32_t trial, const vector<uint32_t>& pit_laps,
+                                   const vector<double>& lap_time, const MonteCarloOptions& options,
+                                   vector<uint8_t>& safety_car, vector<double>& noise,
+                                   vector<double>& times, size_t stride) const {
+    const uint32_t laps = static_cast<uint32_t>(lap_time.size());
+    const uint64_t seed = options.seed;
+
+    uint32_t sc_remaining = 0;
+    const uint64_t sc_stream = trialStream(driver_id, trial, SAFETY_CAR);
+    const uint64_t noise_stream = trialStream(driver_id, trial, LAP_NOISE);
+    for(uint32_t lap = 0; lap < laps; lap++) {
+        if(sc_remaining == 0 && CounterRng::uniform(seed, sc_stream, lap) < model_.track().safety_car_probability) {
+            sc_remaining = SAFETY_CAR_LAPS;
+        }
+        safety_car[lap] = sc_remaining > 0;
+        if(sc_remaining > 0) sc_remaining--;
+        noise[lap] = CounterRng::normal(seed, noise_stream, lap);
+    }
+
+    const double sigma = LAP_NOISE_AT_ZERO_CONSISTENCY * (1.0 - model_.consistency()[driver_id]);
+    const double pit_loss = simulator_.pitLossSeconds(driver_id);
+    const double sc_lap = lap_time[0] * SAFETY_CAR_PACE_FACTOR;
+    const double traffic = CounterRng::uniform(seed, trialStream(driver_id, trial, TRAFFIC), 0)
+                         * model_.track().overtaking_difficulty * TRAFFIC_LOSS_FRACTION * lap_time[0];
+
+    for(size_t c = 0; c < pit_laps.size(); c++) {
+        double time = 0.0;
+        uint32_t age = 0;
+        for(uint32_t lap = 0; lap < laps; lap++) {
+            const bool out_lap = lap == pit_laps[c];
+            if(out_lap) {
+                time += pit_loss * (safety_car[lap] ? SAFETY_CAR_PIT_FACTOR : 1.0);
+                age = 0;
+            }
+
+            double t = lap_time[age] * (1.0 + sigma * noise[lap]);
+            if(safety_car[lap]) {
+                t = max(t, sc_lap);
+            } else if(out_lap) {
+                t += traffic;   // rejoining behind slower cars
+            }
+            time += t;
+            age++;
+        }
+        times[c * stride + trial] = time;
+    }
+}
+
+bool MonteCarloEvaluator::separated(const vector<double>& times, size_t stride, uint32_t trials,
+                                    size_t candidates, size_t best, double z) const {
+    for(size_t c = 0; c < candidates; c++) {
+        if(c == best) continue;
+
+        double sum = 0.0, sum_sq = 0.0;
+        for(uint32_t t = 0; t < trials; t++) {
+            const double d = times[c * stride + t] - times[best * stride + t];
+            sum += d;
+            sum_sq += d * d;
+        }
+        const double mean = sum / trials;
+        const double variance = max(0.0, (sum_sq - sum * mean) / (trials - 1));
+        if(mean - z * sqrt(variance / trials) <= 0.0) return false;
+    }
+    return true;
+}
+
+MonteCarloResult MonteCarloEvaluator::evaluate(uint32_t driver_id, const vector<uint32_t>& pit_laps,
+                                               const MonteCarloOptions& options) const {
+    MonteCarloResult result{driver_id, 0, 0, false, {}};
+    const size_t candidates = pit_laps.size();
+    if(candidates == 0 || options.max_trials < 2) return result;
+
+    const vector<double> stint = simulator_.stintTimes(driver_id);
+    vector<double> lap_time(simulator_.totalLaps());
+    for(size_t age = 0; age < lap_time.size(); age++) {
+        lap_time[age] = stint[age + 1] - stint[age];
+    }
+
+    const size_t stride = options.max_trials;
+    vector<double> times(candidates * stride);
+    vector<double> sums(candidates, 0.0);
+
+    uint32_t trials = 0;
+    size_t best = 0;
+    while(trials < options.max_trials) {
+        uint32_t round = max(options.batch_trials, options.min_trials > trials ? options.min_trials - trials : 0);
+        round = min(max<uint32_t>(round, 1), options.max_trials - trials);
+
+        TaskGroup group;
+        for(uint32_t begin = trials; begin < trials + round; begin += TRIALS_PER_JOB) {
+            const uint32_t end = min(trials + round, begin + TRIALS_PER_JOB);
+            pool_.submit(group, [&, begin, end]() {
+                vector<uint8_t> safety_car(lap_time.size());
+                vector<double> noise(lap_time.size());
+                for(uint32_t t = begin; t < end; t++) {
+                    runTrial(driver_id, t, pit_laps, lap_time, options, safety_car, noise, times, stride);
+                }
+            });
+        }
+        group.wait();
+
+        // Summed in trial order, so the result is the same for any thread count
+        for(size_t c = 0; c < candidates; c++) {
+            for(uint32_t t = trials; t < trials + round; t++) sums[c] += times[c * stride + t];
+        }
+        trials += round;
+
+        best = min_element(sums.begin(), sums.end()) - sums.begin();
+        if(trials >= options.min_trials && trials >= 2 &&
+           separated(times, stride, trials, candidates, best, options.confidence_z)) {
+            result.separated = true;
+            break;
+        }
+    }
+
+    vector<uint32_t> wins(candidates, 0);
+    for(uint32_t t = 0; t < trials; t++) {
+        size_t fastest = 0;
+        for(size_t c = 1; c < candidates; c++) {
+            if(times[c * stride + t] < times[fastest * stride + t]) fastest = c;
+        }
+        wins[fastest]++;
+    }
+
+    vector<double> sorted(trials);
+    for(size_t c = 0; c < candidates; c++) {
+        copy(times.begin() + c * stride, times.begin() + c * stride + trials, sorted.begin());
+        sort(sorted.begin(), sorted.end());
+        result.candidates.push_back({
+            pit_laps[c],
+            static_cast<float>(sums[c] / trials),
+            static_cast<float>(sorted[trials / 10]),
+            static_cast<float>(sorted[(trials * 9) / 10]),
+            static_cast<float>(wins[c]) / trials
+        });
+    }
+
+    result.trials = trials;
+    result.best_pit_lap = pit_laps[best];
+    return result;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "RaceSimulator.h"
+#include "../common/WorkStealingPool.h"
+#include <vector>
+#include <cstdint>
+
+struct MonteCarloOptions {
+    uint64_t seed = 1;
+    uint32_t batch_trials = 256;    // trials added per round before re-checking confidence
+    uint32_t min_trials = 512;
+    uint32_t max_trials = 16384;
+    double confidence_z = 1.96;     // 95% two-sided
+};
+
+struct PitLapDistribution {
+    uint32_t pit_lap;
+    float mean_seconds;
+    float p10_seconds;
+    float p90_seconds;
+    float win_probability;   // share of trials in which this pit lap was the fastest candidate
+};
+
+struct MonteCarloResult {
+    uint32_t driver_id;
+    uint32_t trials;
+    uint32_t best_pit_lap;   // lowest mean
+    bool separated;          // best candidate's lead over every other was significant before max_trials
+    std::vector<PitLapDistribution> candidates;
+};
+
+// Randomized races for one driver over a set of single-stop candidates.
+// Each trial draws a safety-car schedule (per-lap deployment with
+// TrackProfile::safety_car_probability), lap-time noise scaled by the driver's
+// inconsistency and out-lap traffic scaled by overtaking_difficulty; lap times
+// underneath come from the event model's stint costs, so with no randomness a
+// trial reproduces simulateRace. All candidates in a trial see the same draws
+// (common random numbers), which makes their differences far less noisy than
+// their absolute times.
+//
+// Trials run in rounds on the pool. Draws are keyed by (seed, driver, trial),
+// so results don't depend on the thread count. After each round the run stops
+// once the paired confidence interval of (candidate - best) excludes zero for
+// every other candidate.
+class MonteCarloEvaluator {
+public:
+    static constexpr uint32_t SAFETY_CAR_LAPS = 3;
+    static constexpr double SAFETY_CAR_PACE_FACTOR = 1.4;     // SC lap vs. a fresh-tire lap
+    static constexpr double SAFETY_CAR_PIT_FACTOR = 0.5;      // pit loss while the field is neutralized
+    static constexpr double LAP_NOISE_AT_ZERO_CONSISTENCY = 0.02;
+    static constexpr double TRAFFIC_LOSS_FRACTION = 0.5;      // of a lap, at overtaking_difficulty 1.0
+
+    explicit MonteCarloEvaluator(const RaceSimulator& simulator,
+                                 WorkStealingPool& pool = WorkStealingPool::shared());
+
+    MonteCarloResult evaluate(uint32_t driver_id, const std::vector<uint32_t>& pit_laps,
+                              const MonteCarloOptions& options = MonteCarloOptions()) const;
+
+private:
+    const RaceSimulator& simulator_;
+    const RaceModel& model_;
+    WorkStealingPool& pool_;
+
+    static constexpr uint32_t TRIALS_PER_JOB = 64;
+
+    // Finish time of every candidate in one trial, written to times[c * stride + trial].
+    void runTrial(uint32_t driver_id, uint32_t trial, const std::vector<uint32_t>& pit_laps,
+                  const std::vector<double>& lap_time, const MonteCarloOptions& options,
+                  std::vector<uint8_t>& safety_car, std::vector<double>& noise,
+                  std::vector<double>& times, size_t stride) const;
+    bool separated(const std::vector<double>& times, size_t stride, uint32_t trials,
+                   size_t candidates, size_t best, double z) const;
+};
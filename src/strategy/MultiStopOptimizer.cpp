@@ -0,0 +1,62 @@
+#include "MultiStopOptimizer.h"
+#include <limits>
+#include <algorithm>
+
+using namespace std;
+
+MultiStopOptimizer::MultiStopOptimizer(const RaceSimulator& simulator, uint32_t max_stops)
+    : simulator_(simulator), max_stops_(max_stops) {}
+
+StopPlan MultiStopOptimizer::solve(uint32_t driver_id) const {
+    const uint32_t laps = simulator_.totalLaps();
+    const vector<double> stint = simulator_.stintTimes(driver_id);
+    const double pit_loss = simulator_.pitLossSeconds(driver_id);
+    const double INF = numeric_limits<double>::infinity();
+
+    // A stop is taken at the start of lap 1..laps-1, so there can't be more stops than that
+    const uint32_t max_stops = laps > 0 ? min(max_stops_, laps - 1) : 0;
+
+    // best[k][j]: fastest time to the start of lap j having just made stop k there
+    // (k = 0, j = 0 is the race start). prev[k][j] is the lap of stop k-1.
+    vector<vector<double>> best(max_stops + 1, vector<double>(laps + 1, INF));
+    vector<vector<uint32_t>> prev(max_stops + 1, vector<uint32_t>(laps + 1, 0));
+    best[0][0] = 0.0;
+
+    for(uint32_t k = 1; k <= max_stops; k++) {
+        for(uint32_t j = k; j < laps; j++) {
+            for(uint32_t i = k - 1; i < j; i++) {
+                if(best[k - 1][i] == INF) continue;
+                const double t = best[k - 1][i] + stint[j - i] + pit_loss;
+                if(t < best[k][j]) {
+                    best[k][j] = t;
+                    prev[k][j] = i;
+                }
+            }
+        }
+    }
+
+    // Close each partial plan with its final stint to the flag
+    double best_time = INF;
+    uint32_t best_k = 0;
+    uint32_t best_j = 0;
+    for(uint32_t k = 0; k <= max_stops; k++) {
+        for(uint32_t j = 0; j <= laps; j++) {
+            if(best[k][j] == INF) continue;
+            const double t = best[k][j] + stint[laps - j];
+            if(t < best_time) {
+                best_time = t;
+                best_k = k;
+                best_j = j;
+            }
+        }
+    }
+
+    StopPlan plan{driver_id, {}, static_cast<float>(best_time)};
+    for(uint32_t k = best_k, j = best_j; k > 0; k--) {
+        plan.pit_laps.push_back(j);
+        j = prev[k][j];
+    }
+    reverse(plan.pit_laps.begin(), plan.pit_laps.end());
+
+    return plan;
+}
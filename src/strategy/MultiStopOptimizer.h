@@ -0,0 +1,30 @@
+#pragma once
+
+#include "RaceSimulator.h"
+#include <vector>
+#include <cstdint>
+
+struct StopPlan {
+    uint32_t driver_id;
+    std::vector<uint32_t> pit_laps;   // ascending; empty means no stop
+    float finish_time_seconds;
+};
+
+// Exact 0..max_stops pit-stop optimizer over every lap.
+// Each stint starts on fresh tires, so with stint(L) the memoized cost of L laps
+// from new, the race time is stint(p1) + stint(p2 - p1) + ... + stint(N - pk)
+// plus k pit losses. Dynamic programming over (stops made, lap of last stop)
+// - that lap fixes the current tire age - finds the best plan in
+// O(max_stops * laps^2) instead of enumerating every combination of stop laps.
+class MultiStopOptimizer {
+public:
+    static constexpr uint32_t DEFAULT_MAX_STOPS = 3;
+
+    MultiStopOptimizer(const RaceSimulator& simulator, uint32_t max_stops = DEFAULT_MAX_STOPS);
+
+    StopPlan solve(uint32_t driver_id) const;
+
+private:
+    const RaceSimulator& simulator_;
+    uint32_t max_stops_;
+};
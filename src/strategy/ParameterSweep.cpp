@@ -0,0 +1,139 @@
+#include "ParameterSweep.h"
+#include "RaceSimulator.h"
+#include <map>
+#include <array>
+#include <cstring>
+#include <algorithm>
+
+using namespace std;
+
+namespace {
+    bool isTrackParameter(SweepParameter parameter) {
+        return parameter == SweepParameter::TIRE_WEAR_FACTOR || parameter == SweepParameter::LAP_LENGTH_KM;
+    }
+
+    uint32_t floatBits(float v) {
+        uint32_t bits;
+        memcpy(&bits, &v, sizeof(bits));
+        return bits;
+    }
+}
+
+float SweepTable::value(size_t point, size_t axis) const {
+    size_t stride = 1;
+    for(size_t a = axis + 1; a < axes.size(); a++) stride *= axes[a].values.size();
+    return axes[axis].values[(point / stride) % axes[axis].values.size()];
+}
+
+ParameterSweep::ParameterSweep(shared_ptr<const RaceModel> model, WorkStealingPool& pool)
+    : model_(move(model)), pool_(pool) {}
+
+SweepTable ParameterSweep::run(const vector<SweepAxis>& axes, const vector<uint32_t>& driver_ids) const {
+    SweepTable table{axes, driver_ids, {}, 1, 0};
+    for(const auto& axis : axes) table.points *= axis.values.size();
+
+    const RaceModel& model = *model_;
+    const uint32_t total_laps = model.totalLaps();
+    const size_t driver_count = driver_ids.size();
+
+    // Reduce every (point, driver) to the parameters its result depends on and give
+    // each distinct set one lane.
+    vector<float> base_speed, wear_per_lap, lap_length, pit_loss;
+    map<array<uint32_t, 4>, uint32_t> lane_of;
+    vector<uint32_t> row_lane(table.points * driver_count);
+    vector<size_t> index(axes.size(), 0);
+
+    for(size_t point = 0; point < table.points; point++) {
+        for(size_t d = 0; d < driver_count; d++) {
+            const uint32_t id = driver_ids[d];
+            float tire_wear_factor = model.track().tire_wear_factor;
+            float lap_length_km = model.track().lap_length_km;
+            float aggression = model.aggression()[id];
+            float consistency = model.consistency()[id];
+            float engine_power = model.enginePower()[id];
+            float reliability = model.reliability()[id];
+
+            for(size_t a = 0; a < axes.size(); a++) {
+                if(!isTrackParameter(axes[a].parameter) && axes[a].driver_id != id) continue;
+                const float v = axes[a].values[index[a]];
+                switch(axes[a].parameter) {
+                    case SweepParameter::TIRE_WEAR_FACTOR: tire_wear_factor = v; break;
+                    case SweepParameter::LAP_LENGTH_KM: lap_length_km = v; break;
+                    case SweepParameter::AGGRESSION: aggression = v; break;
+                    case SweepParameter::CONSISTENCY: consistency = v; break;
+                    case SweepParameter::ENGINE_POWER: engine_power = v; break;
+                    case SweepParameter::RELIABILITY: reliability = v; break;
+                }
+            }
+
+            const float speed = RaceModel::baseSpeedFor(engine_power, consistency);
+            const float wear = RaceModel::wearPerLapFor(aggression, tire_wear_factor);
+            const float loss = RaceModel::pitLossFor(reliability);
+            const array<uint32_t, 4> key{floatBits(speed), floatBits(wear), floatBits(lap_length_km), floatBits(loss)};
+
+            auto it = lane_of.find(key);
+            if(it == lane_of.end()) {
+                it = lane_of.emplace(key, static_cast<uint32_t>(base_speed.size())).first;
+                base_speed.push_back(speed);
+                wear_per_lap.push_back(wear);
+                lap_length.push_back(lap_length_km);
+                pit_loss.push_back(loss);
+            }
+            row_lane[point * driver_count + d] = it->second;
+        }
+
+        // Next grid point, last axis fastest
+        for(size_t a = axes.size(); a-- > 0; ) {
+            if(++index[a] < axes[a].values.size()) break;
+            index[a] = 0;
+        }
+    }
+
+    const size_t lanes = base_speed.size();
+    table.unique_evaluations = lanes;
+    vector<uint32_t> best_lap(lanes, 0);
+    vector<float> best_time(lanes, 0.0f);
+    // Scratch for all jobs, allocated once; each job works in the slices at its first lane.
+    vector<double> wear(lanes);
+    vector<double> stints((total_laps + 1) * lanes);
+
+    TaskGroup group;
+    for(size_t begin = 0; begin < lanes; begin += LANES_PER_JOB) {
+        pool_.submit(group, [&, begin]() {
+            const size_t count = min(LANES_PER_JOB, lanes - begin);
+            const RaceSimulator::StintLanes block{base_speed.data() + begin, wear_per_lap.data() + begin,
+                                                  lap_length.data() + begin};
+            double* stint = stints.data() + begin * (total_laps + 1);
+            RaceSimulator::stintTimesBatch(block, count, model.track().sectors, total_laps,
+                                           wear.data() + begin, stint);
+
+            // Stopping at the start of lap p splits the race into stints of p and
+            // total_laps - p laps; a race too short to stop in runs non-stop.
+            for(size_t i = 0; i < count; i++) {
+                const double loss = pit_loss[begin + i];
+                uint32_t lap = 0;
+                double time = stint[total_laps * count + i];
+                for(uint32_t p = 1; p < total_laps; p++) {
+                    const double t = stint[p * count + i] + loss + stint[(total_laps - p) * count + i];
+                    if(lap == 0 || t < time) {
+                        lap = p;
+                        time = t;
+                    }
+                }
+                best_lap[begin + i] = lap;
+                best_time[begin + i] = static_cast<float>(time);
+            }
+        });
+    }
+    group.wait();
+
+    table.rows.reserve(row_lane.size());
+    for(size_t point = 0; point < table.points; point++) {
+        for(size_t d = 0; d < driver_count; d++) {
+            const uint32_t lane = row_lane[point * driver_count + d];
+            table.rows.push_back({static_cast<uint32_t>(point), driver_ids[d], best_lap[lane], best_time[lane]});
+        }
+    }
+
+    return table;
+}
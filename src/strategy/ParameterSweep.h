@@ -0,0 +1,73 @@
+#pragma once
+
+#include "../common/RaceModel.h"
+#include "../common/WorkStealingPool.h"
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+// Inputs the single-stop search depends on. Fields that only feed race control,
+// Monte Carlo or the wear-based fallback (overtaking, safety car, tire management,
+// risk tolerance, aero, cooling) don't move the optimal stop and aren't offered.
+enum class SweepParameter {
+    TIRE_WEAR_FACTOR,   // track
+    LAP_LENGTH_KM,      // track
+    AGGRESSION,         // driver
+    CONSISTENCY,        // driver
+    ENGINE_POWER,       // car
+    RELIABILITY         // car
+};
+
+// One dimension of the grid: the parameter is set to each of `values` in turn.
+// driver_id picks the driver/car for per-driver parameters and is ignored for
+// track ones.
+struct SweepAxis {
+    SweepParameter parameter;
+    uint32_t driver_id;
+    std::vector<float> values;
+};
+
+struct SweepRow {
+    uint32_t point;
+    uint32_t driver_id;
+    uint32_t optimal_pit_lap;
+    float finish_time_seconds;
+};
+
+// Grid points are the cartesian product of the axes, numbered with the last axis
+// varying fastest. Rows are point-major, then in the order driver_ids were given.
+struct SweepTable {
+    std::vector<SweepAxis> axes;
+    std::vector<uint32_t> driver_ids;
+    std::vector<SweepRow> rows;
+    size_t points;
+    size_t unique_evaluations;   // distinct parameter sets actually simulated
+
+    float value(size_t point, size_t axis) const;
+    const SweepRow& row(size_t point, size_t driver_index) const { return rows[point * driver_ids.size() + driver_index]; }
+};
+
+// What-if analysis over a grid of perturbed profiles: for every grid point and
+// driver, the best single stop over every lap of the race.
+//
+// Drivers don't interact in the event model, so a driver's result depends only on
+// its own speed, wear rate and pit loss plus the lap length. Every (point, driver)
+// pair is reduced to that parameter set and identical sets are simulated once: a
+// driver that no axis touches costs one evaluation for the whole sweep however many
+// points it has, and an axis over one driver leaves everyone else's work shared.
+// The distinct sets are then run as lanes of RaceSimulator::stintTimesBatch, in
+// blocks spread over the pool, and every pit lap is scored from the stint table.
+class ParameterSweep {
+public:
+    explicit ParameterSweep(std::shared_ptr<const RaceModel> model,
+                            WorkStealingPool& pool = WorkStealingPool::shared());
+
+    SweepTable run(const std::vector<SweepAxis>& axes, const std::vector<uint32_t>& driver_ids) const;
+
+private:
+    std::shared_ptr<const RaceModel> model_;
+    WorkStealingPool& pool_;
+
+    static constexpr size_t LANES_PER_JOB = 64;
+};
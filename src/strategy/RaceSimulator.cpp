@@ -1,105 +1,333 @@
 #include "RaceSimulator.h"
+#include <cmath>
+#include <algorithm>
 
 using namespace std;
 
-RaceSimulator::RaceSimulator(
-    const TrackProfile& track, 
-    const vector<DriverProfile>& drivers, 
-    const vector<CarProfile>& cars, 
-    uint32_t total_laps
-) : track_(track), drivers_(drivers), cars_(cars), total_laps_(total_laps) {
-    states_.resize(drivers.size());
-    for(auto &s : states_) {
-        s.lap = 0;
-        s.sector = 1;
-        s.tire_wear = 0.0f;
-        s.distance_in_lap = 0.0f;
-        s.total_time_seconds = 0.0f;
-        s.has_pitted = false;
-    }
+// Simulated km covered per second per kph of speed
+static constexpr double KM_PER_KPH_SECOND = TickKernel::SIM_SPEED_MULTIPLIER / 3600.0;
+
+RaceSimulator::RaceSimulator(shared_ptr<const RaceModel> model)
+    : model_(move(model)), total_laps_(model_->totalLaps()) {
+    const size_t n = model_->driverCount();
+    const TrackProfile& track = model_->track();
+
+    tick_params_.lap_length_km = track.lap_length_km;
+    tick_params_.sector_length_km = model_->sectorLengthKm();
+    tick_params_.sectors = track.sectors;
+
+    resizeLanes(states_, n);
+    resetStates();
 }
 
-bool RaceSimulator::shouldPit(uint32_t driver_id, uint32_t target_driver_id, uint32_t forced_pit_lap) {
-    const auto &driver = drivers_[driver_id];
-    const auto &state = states_[driver_id];
+void RaceSimulator::resizeLanes(SimLanes& lanes, size_t n) {
+    lanes.lap.assign(n, 0);
+    lanes.sector.assign(n, 1);
+    lanes.tire_wear.assign(n, 0.0f);
+    lanes.distance_in_lap.assign(n, 0.0f);
+    lanes.total_time_seconds.assign(n, 0.0f);
+    lanes.has_pitted.assign(n, 0);
+    lanes.moving.assign(n, 0);
+    lanes.speed.assign(n, 0.0f);
+}
 
+void RaceSimulator::resetStates() {
+    for(size_t i = 0; i < model_->driverCount(); i++) {
+        states_.lap[i] = 0;
+        states_.sector[i] = 1;
+        states_.tire_wear[i] = 0.0f;
+        states_.distance_in_lap[i] = 0.0f;
+        states_.total_time_seconds[i] = 0.0f;
+        states_.has_pitted[i] = 0;
+    }
+}
+
+bool RaceSimulator::shouldPit(uint32_t driver_id, uint32_t target_driver_id, uint32_t forced_pit_lap) const {
     if(driver_id == target_driver_id) {
-        return state.lap == forced_pit_lap && !state.has_pitted;
+        return states_.lap[driver_id] == forced_pit_lap && !states_.has_pitted[driver_id];
     } else {
-        float base_threshold = 0.65f + (driver.tire_management * 0.25f);
-        float risk_adjustment = (driver.risk_tolerance - 0.5f) * 0.15f;
-        float pit_threshold = base_threshold + risk_adjustment;
-        
-        return state.tire_wear > pit_threshold && !state.has_pitted;
+        return states_.tire_wear[driver_id] > model_->pitThreshold()[driver_id] && !states_.has_pitted[driver_id];
     }
 }
 
-void RaceSimulator::updateDriverState(uint32_t driver_id, uint32_t target_driver_id, uint32_t forced_pit_lap) {
-    constexpr float tick_seconds = 0.02f;
+void RaceSimulator::simulateTick(uint32_t target_driver_id, uint32_t pit_lap) {
+    const size_t n = model_->driverCount();
+
+    for(uint32_t i = 0; i < n; i++) {
+        if (shouldPit(i, target_driver_id, pit_lap)) {
+            states_.has_pitted[i] = 1;
+            // Instant pit stop in strategy sim - add time penalty but don't stay in pit
+            states_.total_time_seconds[i] += model_->pitLossSeconds()[i];
+            states_.tire_wear[i] = 0.0f;
+            states_.moving[i] = 0;
+        } else {
+            states_.moving[i] = 1;
+        }
+    }
 
-    auto &state = states_[driver_id];
-    const auto &driver = drivers_[driver_id];
-    const auto &car = cars_[driver_id];
+    TickKernel::DriverLanes lanes{
+        model_->baseSpeed(), model_->wearPerLap(), states_.moving.data(),
+        states_.tire_wear.data(), states_.distance_in_lap.data(),
+        states_.lap.data(), states_.sector.data(), states_.speed.data()
+    };
+    TickKernel::advance(tick_params_, lanes, n);
 
-    if (shouldPit(driver_id, target_driver_id, forced_pit_lap)) {
-        state.has_pitted = true;
-        // Instant pit stop in strategy sim - add time penalty but don't stay in pit
-        state.total_time_seconds += (2.0f + (1.0f - car.reliability) * 1.0f);
-        state.tire_wear = 0.0f;
-        return;
+    for(uint32_t i = 0; i < n; i++) {
+        if (states_.moving[i]) states_.total_time_seconds[i] += TickKernel::TICK_SECONDS;
     }
+}
 
-    // Calculate speed based on driver skill, car performance, and tire wear
-    float driver_skill = 0.80f + driver.consistency * 0.25f;
-    float speed = 220.0f * car.engine_power * driver_skill * (1.0f - state.tire_wear * 0.4f);
+float RaceSimulator::simulateRaceTicks(uint32_t target_driver_id, uint32_t pit_lap) {
+    resetStates();
 
-    // Update distance and lap/sector progression
-    // distance in km; speed is km/h and tick is 20ms
-    // simulation runs ~120x faster than real time for reasonable race duration
-    constexpr float sim_speed_multiplier = 120.0f;
-    const float delta_distance_km = speed * (tick_seconds / 3600.0f) * sim_speed_multiplier;
+    while(states_.lap[target_driver_id] < total_laps_) {
+        simulateTick(target_driver_id, pit_lap);
+    }
 
-    // Tire wear scales with distance traveled (not per tick), matching TelemetryGenerator.
-    const float wear_per_lap = 0.05f * driver.aggression * track_.tire_wear_factor;
-    state.tire_wear += (delta_distance_km / track_.lap_length_km) * wear_per_lap;
-    if (state.tire_wear > 1.0f) state.tire_wear = 1.0f;
+    return states_.total_time_seconds[target_driver_id];
+}
 
-    state.distance_in_lap += delta_distance_km;
+vector<float> RaceSimulator::simulateRaceTicksCandidates(uint32_t target_driver_id,
+                                                         const vector<uint32_t>& pit_laps) const {
+    const size_t n = pit_laps.size();
+    SimLanes lanes;
+    resizeLanes(lanes, n);
+    const vector<float> base_speed(n, model_->baseSpeed()[target_driver_id]);
+    const vector<float> wear_per_lap(n, model_->wearPerLap()[target_driver_id]);
+    const float pit_loss = model_->pitLossSeconds()[target_driver_id];
 
-    float sector_length = track_.lap_length_km / track_.sectors;
+    vector<uint8_t> finished(n, 0);
+    size_t running = n;
+    while(running > 0) {
+        // Same rules as simulateTick() for the target, lane by lane
+        for(size_t i = 0; i < n; i++) {
+            if(finished[i]) {
+                lanes.moving[i] = 0;
+            } else if(lanes.lap[i] == pit_laps[i] && !lanes.has_pitted[i]) {
+                lanes.has_pitted[i] = 1;
+                lanes.total_time_seconds[i] += pit_loss;
+                lanes.tire_wear[i] = 0.0f;
+                lanes.moving[i] = 0;
+            } else {
+                lanes.moving[i] = 1;
+            }
+        }
 
-    while (state.distance_in_lap >= sector_length) {
-        state.distance_in_lap -= sector_length;
-        state.sector++;
+        TickKernel::DriverLanes view{
+            base_speed.data(), wear_per_lap.data(), lanes.moving.data(),
+            lanes.tire_wear.data(), lanes.distance_in_lap.data(),
+            lanes.lap.data(), lanes.sector.data(), lanes.speed.data()
+        };
+        TickKernel::advance(tick_params_, view, n);
 
-        if (state.sector > track_.sectors) {
-            state.sector = 1;
-            state.lap++;
+        for(size_t i = 0; i < n; i++) {
+            if(finished[i]) continue;
+            if(lanes.moving[i]) lanes.total_time_seconds[i] += TickKernel::TICK_SECONDS;
+            if(lanes.lap[i] >= total_laps_) {
+                finished[i] = 1;
+                running--;
+            }
         }
     }
 
-    state.total_time_seconds += tick_seconds;
-} 
+    return lanes.total_time_seconds;
+}
 
-void RaceSimulator::simulateTick(uint32_t target_driver_id, uint32_t pit_lap) {
-    for(uint32_t i = 0; i < drivers_.size(); i++) {
-        updateDriverState(i, target_driver_id, pit_lap);
+float RaceSimulator::simulateRace(uint32_t target_driver_id, uint32_t pit_lap) {
+    // Drivers don't interact, so the target's finish time only depends on its own trajectory.
+    DriverSnapshot state = startSnapshot();
+    advanceDriver(target_driver_id, state, true, pit_lap, total_laps_);
+    return static_cast<float>(state.time_seconds);
+}
+
+vector<float> RaceSimulator::simulatePitCandidates(uint32_t target_driver_id, const vector<uint32_t>& pit_laps) const {
+    return simulatePitCandidates(target_driver_id, startSnapshot(), pit_laps);
+}
+
+vector<float> RaceSimulator::simulatePitCandidates(uint32_t target_driver_id, const DriverSnapshot& from,
+                                                   const vector<uint32_t>& pit_laps) const {
+    vector<float> times(pit_laps.size());
+
+    vector<size_t> by_lap(pit_laps.size());
+    for(size_t i = 0; i < by_lap.size(); i++) by_lap[i] = i;
+    sort(by_lap.begin(), by_lap.end(), [&](size_t a, size_t b) { return pit_laps[a] < pit_laps[b]; });
+
+    // Shared prefix: the target hasn't stopped yet, so every candidate agrees up to its pit lap.
+    constexpr uint32_t NO_PIT = UINT32_MAX;
+    DriverSnapshot prefix = from;
+
+    for(size_t idx : by_lap) {
+        const uint32_t pit_lap = pit_laps[idx];
+        advanceDriver(target_driver_id, prefix, true, NO_PIT, pit_lap);
+
+        DriverSnapshot fork = prefix;
+        advanceDriver(target_driver_id, fork, true, pit_lap, total_laps_);
+        times[idx] = static_cast<float>(fork.time_seconds);
     }
+
+    return times;
 }
 
-float RaceSimulator::simulateRace(uint32_t target_driver_id, uint32_t pit_lap) {
-    for(auto &s : states_){
-        s.lap = 0;
-        s.sector = 1;
-        s.tire_wear = 0.0f;
-        s.distance_in_lap = 0.0f;
-        s.total_time_seconds = 0.0f;
-        s.has_pitted = false;
+float RaceSimulator::simulatePlan(uint32_t target_driver_id, const vector<uint32_t>& pit_laps) const {
+    constexpr uint32_t NO_PIT = UINT32_MAX;
+    DriverSnapshot state = startSnapshot();
+
+    uint32_t pending_stop = NO_PIT;
+    for(uint32_t pit_lap : pit_laps) {
+        advanceDriver(target_driver_id, state, true, pending_stop, pit_lap);
+        // advanceDriver allows one forced stop per call; re-arm it for the next one
+        state.has_pitted = false;
+        pending_stop = pit_lap;
     }
+    advanceDriver(target_driver_id, state, true, pending_stop, total_laps_);
 
-    while(states_[target_driver_id].lap < total_laps_) {
-        simulateTick(target_driver_id, pit_lap);
+    return static_cast<float>(state.time_seconds);
+}
+
+vector<double> RaceSimulator::stintTimes(uint32_t driver_id) const {
+    constexpr uint32_t NO_PIT = UINT32_MAX;
+    vector<double> stint(total_laps_ + 1, 0.0);
+
+    DriverSnapshot state = startSnapshot();
+    for(uint32_t laps = 1; laps <= total_laps_; laps++) {
+        advanceDriver(driver_id, state, true, NO_PIT, laps);
+        stint[laps] = state.time_seconds;
     }
 
-    return states_[target_driver_id].total_time_seconds;
-}
\ No newline at end of file
+    return stint;
+}
+
+RaceSimulator::DriverSnapshot RaceSimulator::startSnapshot() const {
+    return {0, 1, 0.0, 0.0, 0.0, false};
+}
+
+RaceSimulator::DriverSnapshot RaceSimulator::snapshotFromLive(const DriverState& live, uint64_t now_ns) const {
+    DriverSnapshot state{live.lap, live.sector, live.distance_in_lap, live.tire_wear, 0.0, live.has_pitted};
+    if(live.is_on_pit) {
+        // Tires are fresh on exit; a penalty served in this stop is already in the end time.
+        state.has_pitted = true;
+        state.tire_wear = 0.0;
+        if(live.pit_stop_end_time_ns > now_ns) {
+            state.time_seconds = (live.pit_stop_end_time_ns - now_ns) * 1e-9;
+        }
+    }
+    return state;
+}
+
+// Time to cover distance_km starting at `wear`, assuming wear stays below 1.0 over the step.
+// speed(x) = base * (1 - 0.4 * (wear + c x)) and dt = dx / (k * speed), which integrates to a log.
+static double closedFormTravelTime(double base_km_per_second, double c, double wear, double distance_km) {
+    const double start = 1.0 - 0.4 * wear;
+    const double end = 1.0 - 0.4 * (wear + c * distance_km);
+    if (c * distance_km < 1e-9) {
+        return distance_km / (base_km_per_second * start);
+    }
+    return std::log(start / end) / (base_km_per_second * 0.4 * c);
+}
+
+double RaceSimulator::travelTime(uint32_t driver_id, double wear, double distance_km) const {
+    const double base = model_->baseSpeed()[driver_id] * KM_PER_KPH_SECOND;
+    const double c = model_->wearPerLap()[driver_id] / static_cast<double>(tick_params_.lap_length_km);
+    return closedFormTravelTime(base, c, wear, distance_km);
+}
+
+void RaceSimulator::stintTimesBatch(const StintLanes& lanes, size_t count, uint8_t sectors,
+                                    uint32_t total_laps, double* wear, double* stints) {
+    for(size_t i = 0; i < count; i++) {
+        wear[i] = 0.0;
+        stints[i] = 0.0;
+    }
+
+    for(uint32_t lap = 1; lap <= total_laps; lap++) {
+        // Each lap accumulates onto a copy of the previous stint row.
+        const double* prev = stints + static_cast<size_t>(lap - 1) * count;
+        double* row = stints + static_cast<size_t>(lap) * count;
+        for(size_t i = 0; i < count; i++) row[i] = prev[i];
+
+        for(uint8_t sector = 0; sector < sectors; sector++) {
+            for(size_t i = 0; i < count; i++) {
+                // Same steps as advanceDriver() for a target that doesn't stop, taken as a
+                // fixed two-step sector: the part run before the tires saturate, then the
+                // rest at the dead-tire speed. Either part may be empty; both are always
+                // computed and the empty one blended away, so every lane runs the same
+                // instructions.
+                const double sector_length = static_cast<float>(lanes.lap_length_km[i] / sectors);
+                const double base = lanes.base_speed[i] * KM_PER_KPH_SECOND;
+                const double c = lanes.wear_per_lap[i] / static_cast<double>(lanes.lap_length_km[i]);
+                const double w = wear[i];
+
+                const double to_saturation = c > 0.0 ? (1.0 - w) / c : sector_length;
+                const double worn = w < 1.0 ? std::min(sector_length, to_saturation) : 0.0;
+                const double dead = sector_length - worn;
+
+                // closedFormTravelTime() with its near-constant-speed branch as a select.
+                const double start = 1.0 - 0.4 * w;
+                const double end = 1.0 - 0.4 * (w + c * worn);
+                const double flat = worn / (base * start);
+                const double curved = std::log(start / end) / (base * 0.4 * (c > 0.0 ? c : 1.0));
+                const double worn_time = c * worn < 1e-9 ? flat : curved;
+
+                row[i] += worn_time + dead / (base * 0.6);
+                wear[i] = std::min(1.0, w + c * worn);
+            }
+        }
+    }
+}
+
+void RaceSimulator::advanceDriver(uint32_t driver_id, DriverSnapshot& state, bool is_target,
+                                  uint32_t forced_pit_lap, uint32_t stop_lap) const {
+    const double sector_length = tick_params_.sector_length_km;
+    const double c = model_->wearPerLap()[driver_id] / static_cast<double>(tick_params_.lap_length_km);
+    const double threshold = model_->pitThreshold()[driver_id];
+    const uint32_t end_lap = std::min(stop_lap, total_laps_);
+
+    uint32_t lap = state.lap;
+    uint32_t sector = state.sector;
+    double distance = state.distance_in_sector;
+    double wear = state.tire_wear;
+    double time = state.time_seconds;
+    bool has_pitted = state.has_pitted;
+
+    while (lap < end_lap) {
+        // Same pit rules as shouldPit(), evaluated at event boundaries instead of every tick
+        const bool pit_now = is_target
+            ? (lap == forced_pit_lap && !has_pitted)
+            : (wear > threshold && !has_pitted);
+        if (pit_now) {
+            has_pitted = true;
+            time += model_->pitLossSeconds()[driver_id];
+            wear = 0.0;
+        }
+
+        // Next event: sector boundary, wear reaching the pit threshold, or wear saturating.
+        double step = sector_length - distance;
+        if (c > 0.0) {
+            if (!is_target && !has_pitted && wear <= threshold) {
+                step = std::min(step, (threshold - wear) / c + 1e-9);
+            }
+            if (wear < 1.0) {
+                step = std::min(step, (1.0 - wear) / c);
+            }
+        }
+
+        if (wear >= 1.0) {
+            // Fully worn: constant speed (60% of base) until the next boundary
+            time += step / (model_->baseSpeed()[driver_id] * KM_PER_KPH_SECOND * 0.6);
+        } else {
+            time += travelTime(driver_id, wear, step);
+            wear = std::min(1.0, wear + c * step);
+        }
+
+        distance += step;
+        if (distance >= sector_length - 1e-9) {
+            distance = 0.0;
+            sector++;
+            if (sector > tick_params_.sectors) {
+                sector = 1;
+                lap++;
+            }
+        }
+    }
+
+    state = {lap, sector, distance, wear, time, has_pitted};
+}
@@ -1,39 +1,125 @@
 #pragma once
 
 #include "../common/types.h"
+#include "../common/RaceModel.h"
+#include "../physics/TickKernel.h"
 #include <vector>
 #include <cstdint>
 #include <map>
+#include <memory>
 
 class RaceSimulator {
 public:
-    RaceSimulator(
-        const TrackProfile& track, 
-        const std::vector<DriverProfile>& drivers, 
-        const std::vector<CarProfile>& cars, 
-        uint32_t total_laps
-    );
+    // Complete event-model state for one driver. Plain data, so copying it is a
+    // snapshot and continuing from the copy is a fork.
+    struct DriverSnapshot {
+        uint32_t lap;
+        uint32_t sector;
+        double distance_in_sector;
+        double tire_wear;
+        double time_seconds;
+        bool has_pitted;
+    };
+
+    // Bump whenever the speed, wear or pit model changes what a given input produces.
+    // Results persisted across runs (StrategyCache entries, StrategySurrogate tables)
+    // are keyed on it, so a bump retires them.
+    static constexpr uint32_t MODEL_VERSION = 1;
+
+    // Shares the model; constructing a simulator copies no profiles.
+    explicit RaceSimulator(std::shared_ptr<const RaceModel> model);
 
+    // Event-stepped: integrates the target's speed/wear model in closed form between
+    // sector boundaries and pit/wear events (~160 steps per race instead of ~4500 ticks
+    // for the whole field). Agrees with simulateRaceTicks to within EVENT_TOLERANCE_SECONDS.
     float simulateRace(uint32_t target_driver_id, uint32_t pit_lap);
 
+    // Finish times for each candidate pit lap (same order as pit_laps), matching
+    // simulateRace exactly. The no-stop prefix is simulated once; at each candidate
+    // lap the state is snapshotted and forked, so N candidates cost one race plus
+    // N tails instead of N full races. Reads no mutable state, so one simulator can
+    // serve concurrent callers.
+    std::vector<float> simulatePitCandidates(uint32_t target_driver_id, const std::vector<uint32_t>& pit_laps) const;
+
+    // Same, for the rest of a race already under way from `from` (finish times are
+    // then measured from that point).
+    std::vector<float> simulatePitCandidates(uint32_t target_driver_id, const DriverSnapshot& from,
+                                             const std::vector<uint32_t>& pit_laps) const;
+
+    DriverSnapshot startSnapshot() const;
+    // Seeds the event model from TelemetryGenerator's live state at now_ns. A driver in
+    // the pits counts as having stopped, with the rest of the stop added as time.
+    DriverSnapshot snapshotFromLive(const DriverState& live, uint64_t now_ns) const;
+    // Advances `state` until it reaches stop_lap (or the finish). A target pits once at
+    // forced_pit_lap; other drivers pit once on their wear threshold.
+    void advanceDriver(uint32_t driver_id, DriverSnapshot& state, bool is_target,
+                       uint32_t forced_pit_lap, uint32_t stop_lap) const;
+
+    // Finish time for the target stopping at every lap in pit_laps (ascending, any count).
+    float simulatePlan(uint32_t target_driver_id, const std::vector<uint32_t>& pit_laps) const;
+
+    // stint[L] = time to run L laps from fresh tires, for L = 0..total_laps. Tires wear
+    // with distance alone, so a stint's cost depends only on its length and a race is the
+    // sum of its stints plus pit losses.
+    std::vector<double> stintTimes(uint32_t driver_id) const;
+    // stintTimes() for many independent parameter sets at once (the kernel behind
+    // ParameterSweep). Lane i drives at base_speed[i] kph with wear_per_lap[i] on a lap
+    // of lap_length_km[i]; all lanes share the sector count and race length. Lanes
+    // advance in lockstep, sector by sector, over structure-of-arrays state, and
+    // stints[L * count + i] receives lane i's L-lap stint for L = 0..total_laps,
+    // identical to stintTimes() on a model with the same parameters. wear is count
+    // doubles of caller-owned scratch, so the kernel itself never allocates.
+    struct StintLanes {
+        const float* base_speed;
+        const float* wear_per_lap;
+        const float* lap_length_km;
+    };
+    static void stintTimesBatch(const StintLanes& lanes, size_t count, uint8_t sectors,
+                                uint32_t total_laps, double* wear, double* stints);
+
+    float pitLossSeconds(uint32_t driver_id) const { return model_->pitLossSeconds()[driver_id]; }
+    uint32_t totalLaps() const { return total_laps_; }
+    const std::shared_ptr<const RaceModel>& model() const { return model_; }
+
+    // Reference fixed-tick model (20 ms ticks, whole field).
+    float simulateRaceTicks(uint32_t target_driver_id, uint32_t pit_lap);
+
+    // Tick model for every candidate at once, one scenario per TickKernel lane: each
+    // lane is the target with its own pit lap, and a lane is masked out (moving = 0)
+    // while it pits and once it has finished. Other drivers never affect the target,
+    // so they aren't simulated; eight candidates cost one AVX2 step per tick, about
+    // what a single whole-field race costs. Matches simulateRaceTicks per candidate
+    // bit for bit. Allocates its own lanes, so concurrent callers are fine.
+    std::vector<float> simulateRaceTicksCandidates(uint32_t target_driver_id,
+                                                   const std::vector<uint32_t>& pit_laps) const;
+
+    // Tick quantization (finish and pit detected on tick boundaries) plus float
+    // accumulation of 20 ms steps in the tick model.
+    static constexpr float EVENT_TOLERANCE_SECONDS = 0.05f;
+
 private:
-    struct DriverSimState {
-        uint32_t lap;
-        uint8_t sector;
-        float tire_wear;
-        float distance_in_lap;
-        float total_time_seconds;
-        bool has_pitted;
+    // Per-driver state stored structure-of-arrays so TickKernel can advance
+    // the whole field in SIMD lanes.
+    struct SimLanes {
+        std::vector<uint32_t> lap;
+        std::vector<uint32_t> sector;
+        std::vector<float> tire_wear;
+        std::vector<float> distance_in_lap;
+        std::vector<float> total_time_seconds;
+        std::vector<uint8_t> has_pitted;
+        std::vector<uint8_t> moving;   // scratch: 0 for drivers pitting this tick
+        std::vector<float> speed;      // scratch: kernel output
     };
 
-    TrackProfile track_;
-    std::vector<DriverProfile> drivers_;
-    std::vector<CarProfile> cars_;
+    std::shared_ptr<const RaceModel> model_;
     uint32_t total_laps_;
+    TickKernel::TickParams tick_params_;
 
-    std::vector<DriverSimState> states_;
+    SimLanes states_;
 
+    static void resizeLanes(SimLanes& lanes, size_t n);
+    void resetStates();
+    double travelTime(uint32_t driver_id, double wear, double distance_km) const;
     void simulateTick(uint32_t target_driver_id, uint32_t pit_lap);
-    void updateDriverState(uint32_t driver_id, uint32_t target_driver_id, uint32_t forced_pit_lap);
-    bool shouldPit(uint32_t driver_id, uint32_t target_driver_id, uint32_t forced_pit_lap);
+    bool shouldPit(uint32_t driver_id, uint32_t target_driver_id, uint32_t forced_pit_lap) const;
 };
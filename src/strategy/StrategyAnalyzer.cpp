@@ -1,46 +1,129 @@
 #include "StrategyAnalyzer.h"
-#include <future>
+#include <algorithm>
 
 using namespace std;
 
+// Ascending, so each job's candidates share one forked prefix
 const vector<uint32_t> StrategyAnalyzer::PIT_LAPS_TO_TEST = {12, 15, 18, 21, 24, 27, 30, 33, 36, 39};
 
 StrategyAnalyzer::StrategyAnalyzer(
-    const TrackProfile& track,
-    const vector<DriverProfile>& drivers,
-    const vector<CarProfile>& cars,
-    uint32_t total_laps
-) : track_(track), drivers_(drivers), cars_(cars), total_laps_(total_laps) {}
-
-vector<StrategyResult> StrategyAnalyzer::analyzeStrategies(const std::vector<uint32_t>& driver_ids_to_optimize) {
-    vector<StrategyResult> results;
-
-    for(uint32_t i = 0; i < driver_ids_to_optimize.size(); i++) {
-        uint32_t driver_id = driver_ids_to_optimize[i];
-        StrategyResult result = findOptimalForDriver(driver_id);
-        results.push_back(result);
+    shared_ptr<const RaceModel> model,
+    WorkStealingPool& pool,
+    StrategyCache* cache
+) : model_(move(model)), total_laps_(model_->totalLaps()), pool_(pool),
+    cancel_requested_(false), cache_(cache) {}
+
+void StrategyAnalyzer::analyzeProgressive(const std::vector<uint32_t>& driver_ids_to_optimize, const StrategyUpdate& on_update,
+                                          const StrategyProgress& progress) {
+    const RaceSimulator simulator(model_);
+    vector<uint32_t> refined_key = PIT_LAPS_TO_TEST;
+    refined_key.push_back(REFINED_CACHE_TAG);
+    const uint64_t coarse_hash = StrategyCache::inputHash(*model_, PIT_LAPS_TO_TEST);
+    const uint64_t refined_hash = StrategyCache::inputHash(*model_, refined_key);
+
+    TaskGroup group;
+    for(uint32_t driver_id : driver_ids_to_optimize) {
+        pool_.submit(group, [&, driver_id]() {
+            if(cancel_requested_.load(memory_order_relaxed)) return;
+
+            StrategyResult best;
+            if(cache_ && cache_->lookup(refined_hash, driver_id, best)) {
+                on_update(best);
+                return;
+            }
+
+            if(!cache_ || !cache_->lookup(coarse_hash, driver_id, best)) {
+                best = pickBest(driver_id, simulator.simulatePitCandidates(driver_id, PIT_LAPS_TO_TEST));
+                if(cache_) cache_->store(coarse_hash, best);
+            }
+            on_update(best);
+
+            if(cancel_requested_.load(memory_order_relaxed)) return;
+
+            const vector<uint32_t> laps = refinementLaps(best.optimal_pit_lap);
+            const vector<float> times = simulator.simulatePitCandidates(driver_id, laps);
+            bool improved = false;
+            for(size_t i = 0; i < laps.size(); i++) {
+                if(times[i] < best.finish_time_seconds) {
+                    best = {driver_id, laps[i], times[i]};
+                    improved = true;
+                }
+            }
+            if(improved) on_update(best);
+            if(cache_) cache_->store(refined_hash, best);
+        });
     }
 
+    waitReporting(group, progress);
+}
+
+vector<uint32_t> StrategyAnalyzer::refinementLaps(uint32_t coarse_best) const {
+    // Everything strictly between the grid neighbours of the coarse winner
+    const auto it = lower_bound(PIT_LAPS_TO_TEST.begin(), PIT_LAPS_TO_TEST.end(), coarse_best);
+    const uint32_t low = (it == PIT_LAPS_TO_TEST.begin()) ? 0 : *(it - 1);
+    const uint32_t high = (it == PIT_LAPS_TO_TEST.end() || it + 1 == PIT_LAPS_TO_TEST.end()) ? total_laps_ : *(it + 1);
+
+    vector<uint32_t> laps;
+    for(uint32_t lap = max<uint32_t>(low + 1, 1); lap < high && lap < total_laps_; lap++) {
+        if(lap != coarse_best) laps.push_back(lap);
+    }
+    return laps;
+}
+
+vector<StopPlan> StrategyAnalyzer::analyzeMultiStop(const std::vector<uint32_t>& driver_ids_to_optimize, uint32_t max_stops,
+                                                    const StrategyProgress& progress) {
+    const RaceSimulator simulator(model_);
+    const MultiStopOptimizer optimizer(simulator, max_stops);
+    vector<StopPlan> plans(driver_ids_to_optimize.size());
+    vector<uint8_t> done(driver_ids_to_optimize.size(), 0);
+
+    TaskGroup group;
+    for(size_t d = 0; d < driver_ids_to_optimize.size(); d++) {
+        pool_.submit(group, [&, d]() {
+            if(cancel_requested_.load(memory_order_relaxed)) return;
+            plans[d] = optimizer.solve(driver_ids_to_optimize[d]);
+            done[d] = 1;
+        });
+    }
+
+    waitReporting(group, progress);
+
+    vector<StopPlan> results;
+    for(size_t d = 0; d < plans.size(); d++) {
+        if(done[d]) results.push_back(move(plans[d]));
+    }
     return results;
 }
 
-StrategyResult StrategyAnalyzer::findOptimalForDriver(uint32_t driver_id) {
-    vector<future<float>> futures;
+vector<MonteCarloResult> StrategyAnalyzer::analyzeMonteCarlo(const std::vector<uint32_t>& driver_ids_to_optimize,
+                                                             const MonteCarloOptions& options,
+                                                             const StrategyProgress& progress) {
+    const RaceSimulator simulator(model_);
+    const MonteCarloEvaluator evaluator(simulator, pool_);
 
-    for(uint32_t i = 0; i < PIT_LAPS_TO_TEST.size(); i++) {
-        futures.push_back(
-            async(launch::async, [=](){
-                RaceSimulator simulator(track_, drivers_, cars_, total_laps_);
-                return simulator.simulateRace(driver_id, PIT_LAPS_TO_TEST[i]);
-            })
-        );
+    vector<MonteCarloResult> results;
+    for(uint32_t driver_id : driver_ids_to_optimize) {
+        if(cancel_requested_.load(memory_order_relaxed)) break;
+        results.push_back(evaluator.evaluate(driver_id, PIT_LAPS_TO_TEST, options));
+        if(progress) progress(results.size(), driver_ids_to_optimize.size());
     }
+    return results;
+}
 
+void StrategyAnalyzer::waitReporting(TaskGroup& group, const StrategyProgress& progress) {
+    while(!group.waitFor(chrono::milliseconds(PROGRESS_INTERVAL_MS))) {
+        if(cancel_requested_.load(memory_order_relaxed)) group.cancel();
+        if(progress) progress(group.completed(), group.submitted());
+    }
+    if(progress) progress(group.completed(), group.submitted());
+}
+
+StrategyResult StrategyAnalyzer::pickBest(uint32_t driver_id, const vector<float>& times) {
     uint32_t best_pit_lap = PIT_LAPS_TO_TEST[0];
-    float best_time = futures[0].get();
+    float best_time = times[0];
 
     for(uint32_t i = 1; i < PIT_LAPS_TO_TEST.size(); i++) {
-        float time = futures[i].get();
+        float time = times[i];
         
         if(time < best_time) {
             best_time = time;
@@ -49,4 +132,4 @@ StrategyResult StrategyAnalyzer::findOptimalForDriver(uint32_t driver_id) {
     }
 
     return {driver_id, best_pit_lap, best_time};
-}
\ No newline at end of file
+}
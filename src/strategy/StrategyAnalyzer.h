@@ -1,10 +1,18 @@
 #pragma once
 
 #include "../common/types.h"
+#include "../common/RaceModel.h"
+#include "../common/WorkStealingPool.h"
 #include "RaceSimulator.h"
+#include "MultiStopOptimizer.h"
+#include "MonteCarloEvaluator.h"
+#include "StrategyCache.h"
 #include <vector>
 #include <cstdint>
 #include <string>
+#include <atomic>
+#include <functional>
+#include <memory>
 
 struct StrategyResult {
     uint32_t driver_id;
@@ -12,24 +20,58 @@ struct StrategyResult {
     float finish_time_seconds;
 };
 
+// Called from pool threads, possibly concurrently, whenever a driver's plan improves.
+using StrategyUpdate = std::function<void(const StrategyResult&)>;
+// Called on the analyzing thread about every PROGRESS_INTERVAL_MS and once at the
+// end, with (jobs finished, jobs total) of the analysis running.
+using StrategyProgress = std::function<void(size_t, size_t)>;
+
 class StrategyAnalyzer {
 public:
     StrategyAnalyzer(
-        const TrackProfile& track,
-        const std::vector<DriverProfile>& drivers,
-        const std::vector<CarProfile>& cars,
-        uint32_t total_laps
+        std::shared_ptr<const RaceModel> model,
+        WorkStealingPool& pool = WorkStealingPool::shared(),
+        StrategyCache* cache = nullptr
     );
 
-    std::vector<StrategyResult> analyzeStrategies(const std::vector<uint32_t>& driver_ids_to_optimize);
+    // Anytime search, so it can run alongside the race: each driver's coarse-grid result
+    // is reported as soon as it is known, then every lap between its neighbouring grid
+    // candidates is tried and an improvement reported again. Results found in the cache
+    // (if any) skip simulation, and new ones are written back. Blocks until all drivers
+    // are refined (or cancel()).
+    void analyzeProgressive(const std::vector<uint32_t>& driver_ids_to_optimize, const StrategyUpdate& on_update,
+                            const StrategyProgress& progress = nullptr);
+
+    // Best 0..max_stops plan over every lap for each driver, one pool job per driver.
+    std::vector<StopPlan> analyzeMultiStop(const std::vector<uint32_t>& driver_ids_to_optimize,
+                                           uint32_t max_stops = MultiStopOptimizer::DEFAULT_MAX_STOPS,
+                                           const StrategyProgress& progress = nullptr);
+
+    // Randomized (safety car, lap noise, traffic) evaluation of the single-stop candidates.
+    // Each driver's trials are spread across the pool; progress counts drivers.
+    std::vector<MonteCarloResult> analyzeMonteCarlo(const std::vector<uint32_t>& driver_ids_to_optimize,
+                                                    const MonteCarloOptions& options = MonteCarloOptions(),
+                                                    const StrategyProgress& progress = nullptr);
+
+    // Safe from any thread. Stops the analysis running and makes any later one return
+    // at once; each keeps only the drivers it finished. There is no undoing it.
+    void cancel() { cancel_requested_.store(true, std::memory_order_relaxed); }
 
 private:
-    TrackProfile track_;
-    std::vector<DriverProfile> drivers_;
-    std::vector<CarProfile> cars_;
+    std::shared_ptr<const RaceModel> model_;
     uint32_t total_laps_;
+    WorkStealingPool& pool_;
+    std::atomic<bool> cancel_requested_;
+    StrategyCache* cache_;
 
     static const std::vector<uint32_t> PIT_LAPS_TO_TEST;
+    static constexpr int PROGRESS_INTERVAL_MS = 50;
+
+    // Marks refined results in the cache so they don't collide with coarse ones
+    static constexpr uint32_t REFINED_CACHE_TAG = UINT32_MAX;
 
-    StrategyResult findOptimalForDriver(uint32_t driver_id);
+    std::vector<uint32_t> refinementLaps(uint32_t coarse_best) const;
+    // Waits for the group, passing on cancel() and reporting progress meanwhile
+    void waitReporting(TaskGroup& group, const StrategyProgress& progress);
+    static StrategyResult pickBest(uint32_t driver_id, const std::vector<float>& times);
 };
@@ -0,0 +1,166 @@
+#include "StrategyCache.h"
+#include "StrategyAnalyzer.h"
+#include "RaceSimulator.h"
+#include "../common/ContentHash.h"
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+
+using namespace std;
+
+namespace {
+    const char MAGIC[4] = {'F', '1', 'S', 'C'};
+}
+
+StrategyCache::StrategyCache(const string& path) : fd_(-1), mapping_(nullptr), slots_(nullptr) {
+    // Another process may replace the file while we wait for its lock; then start over on the new one
+    int fd = -1;
+    for(int attempt = 0; attempt < 3 && fd < 0; attempt++) {
+        fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if(fd < 0) return;
+        if(flock(fd, LOCK_EX) != 0) {
+            close(fd);
+            return;
+        }
+
+        struct stat opened, current;
+        const bool replaced = fstat(fd, &opened) != 0 || stat(path.c_str(), &current) != 0 ||
+                              opened.st_dev != current.st_dev || opened.st_ino != current.st_ino;
+        if(replaced || !hasCurrentLayout(fd)) {
+            // New file, older layout or foreign file: swap in an empty one and reopen that
+            const bool retry = replaced || replaceWithEmpty(path);
+            close(fd);
+            fd = -1;
+            if(!retry) return;
+        }
+    }
+    if(fd < 0) return;
+
+    void* mapping = mmap(nullptr, fileSize(), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    flock(fd, LOCK_UN);
+    if(mapping == MAP_FAILED) {
+        close(fd);
+        return;
+    }
+    fd_ = fd;
+    mapping_ = mapping;
+    slots_ = reinterpret_cast<Slot*>(static_cast<char*>(mapping_) + sizeof(Header));
+}
+
+StrategyCache::~StrategyCache() {
+    if(mapping_) munmap(mapping_, fileSize());
+    if(fd_ >= 0) close(fd_);
+}
+
+bool StrategyCache::hasCurrentLayout(int fd) {
+    struct stat st;
+    Header header;
+    return fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) == fileSize() &&
+           pread(fd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header)) &&
+           memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0 && header.format_version == FORMAT_VERSION &&
+           header.slot_count == SLOT_COUNT;
+}
+
+// Never truncates a file someone may have mapped (that would SIGBUS them): the empty
+// table is written aside and renamed over path.
+bool StrategyCache::replaceWithEmpty(const string& path) {
+    const string tmp_path = path + ".tmp";
+    int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(fd < 0) return false;
+
+    Header header{};
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.format_version = FORMAT_VERSION;
+    header.slot_count = SLOT_COUNT;
+    bool ok = ftruncate(fd, fileSize()) == 0 &&
+              pwrite(fd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header));
+    ok = close(fd) == 0 && ok;
+    if(!ok || rename(tmp_path.c_str(), path.c_str()) != 0) {
+        unlink(tmp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+uint64_t StrategyCache::inputHash(const RaceModel& model, const vector<uint32_t>& candidate_laps) {
+    ContentHash hasher;
+    hasher.u32(RaceSimulator::MODEL_VERSION);
+
+    const uint64_t model_hash = model.contentHash();
+    hasher.bytes(&model_hash, sizeof(model_hash));
+
+    hasher.u32(static_cast<uint32_t>(candidate_laps.size()));
+    for(uint32_t lap : candidate_laps) hasher.u32(lap);
+
+    return hasher.finish();
+}
+
+uint64_t StrategyCache::entryKey(uint64_t input_hash, uint32_t driver_id) {
+    ContentHash hasher;
+    hasher.bytes(&input_hash, sizeof(input_hash));
+    hasher.u32(driver_id);
+    uint64_t key = hasher.finish();
+    return key == 0 ? 1 : key;
+}
+
+bool StrategyCache::readSlot(const Slot& slot, uint64_t& key, StrategyResult& out) {
+    const uint32_t before = slot.sequence.load(memory_order_acquire);
+    if(before & 1) return false;
+    key = slot.key;
+    out = {slot.driver_id, slot.optimal_pit_lap, slot.finish_time_seconds};
+    atomic_thread_fence(memory_order_acquire);
+    return slot.sequence.load(memory_order_relaxed) == before;
+}
+
+bool StrategyCache::lookup(uint64_t input_hash, uint32_t driver_id, StrategyResult& out) const {
+    if(!slots_) return false;
+
+    const uint64_t key = entryKey(input_hash, driver_id);
+    for(uint32_t probe = 0; probe < MAX_PROBE; probe++) {
+        const Slot& slot = slots_[(key + probe) & (SLOT_COUNT - 1)];
+        uint64_t slot_key;
+        StrategyResult entry;
+        // A slot mid-write (or abandoned by a crashed writer) is a miss, not a wait
+        if(!readSlot(slot, slot_key, entry)) return false;
+        if(slot_key == 0) return false;
+        if(slot_key == key && entry.driver_id == driver_id) {
+            out = entry;
+            return true;
+        }
+    }
+    return false;
+}
+
+void StrategyCache::store(uint64_t input_hash, const StrategyResult& result) {
+    if(!slots_) return;
+
+    const uint64_t key = entryKey(input_hash, result.driver_id);
+    lock_guard<mutex> lock(write_mutex_);
+    if(flock(fd_, LOCK_EX) != 0) return;
+
+    // Reuse the entry's own slot or the first empty one; with the window full,
+    // evict the home slot.
+    Slot* target = &slots_[key & (SLOT_COUNT - 1)];
+    for(uint32_t probe = 0; probe < MAX_PROBE; probe++) {
+        Slot& slot = slots_[(key + probe) & (SLOT_COUNT - 1)];
+        if(slot.key == 0 || slot.key == key) {
+            target = &slot;
+            break;
+        }
+    }
+
+    // Odd while writing; an odd value left by a crashed writer is simply reused
+    const uint32_t writing = target->sequence.load(memory_order_relaxed) | 1;
+    target->sequence.store(writing, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    target->driver_id = result.driver_id;
+    target->key = key;
+    target->optimal_pit_lap = result.optimal_pit_lap;
+    target->finish_time_seconds = result.finish_time_seconds;
+    target->sequence.store(writing + 1, memory_order_release);
+
+    flock(fd_, LOCK_UN);
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "../common/RaceModel.h"
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <mutex>
+#include <atomic>
+
+struct StrategyResult;
+
+// Persistent memo of single-stop strategy results, one file shared across runs.
+//
+// Entries are keyed by a 64-bit content hash of everything a result depends on:
+// the RaceModel's content hash (every profile field and total_laps), the candidate
+// laps, RaceSimulator::MODEL_VERSION and the driver id. Changing any input changes the key, so
+// stale entries are simply never hit again; no explicit invalidation exists.
+//
+// The file is a fixed header plus an open-addressed table of SLOT_COUNT slots,
+// mapped read-write (MAP_SHARED). A lookup hashes straight to a slot and probes at
+// most MAX_PROBE neighbours, so hits cost O(1) with no parsing at startup. A file
+// with the wrong magic, version or size is replaced by an empty one (written aside
+// and renamed over it, so processes still mapping the old file are unaffected).
+//
+// Several processes (f1-telemetry and f1-telemetry-gemini) can share the file:
+// writers take an flock on it, and each slot is a seqlock, so lookups never lock
+// and never see a half-written or crash-truncated entry.
+class StrategyCache {
+public:
+    static constexpr const char* DEFAULT_PATH = ".f1-strategy-cache";
+
+    // Opens (or creates) the cache file at path.
+    explicit StrategyCache(const std::string& path = DEFAULT_PATH);
+    ~StrategyCache();
+
+    StrategyCache(const StrategyCache&) = delete;
+    StrategyCache& operator=(const StrategyCache&) = delete;
+
+    // False if the file couldn't be opened or mapped; lookups then always miss.
+    bool isOpen() const { return slots_ != nullptr; }
+
+    static uint64_t inputHash(const RaceModel& model, const std::vector<uint32_t>& candidate_laps);
+
+    // Both are safe to call from several threads and processes at once.
+    bool lookup(uint64_t input_hash, uint32_t driver_id, StrategyResult& out) const;
+    void store(uint64_t input_hash, const StrategyResult& result);
+
+private:
+    static constexpr uint32_t FORMAT_VERSION = 2;
+    static constexpr uint32_t SLOT_COUNT = 4096;   // power of two
+    static constexpr uint32_t MAX_PROBE = 8;
+
+    struct Header {
+        char magic[4];             // "F1SC"
+        uint32_t format_version;
+        uint32_t slot_count;
+        uint32_t reserved;
+    };
+
+    // sequence is odd while the slot is being written; a writer that crashed
+    // leaves it odd, so the slot reads as a miss until it's overwritten.
+    // key == 0 marks an empty slot.
+    struct Slot {
+        std::atomic<uint32_t> sequence;
+        uint32_t driver_id;
+        uint64_t key;
+        uint32_t optimal_pit_lap;
+        float finish_time_seconds;
+    };
+    static_assert(std::atomic<uint32_t>::is_always_lock_free, "Slot::sequence is shared between processes");
+    static_assert(sizeof(Slot) == 24, "Slot is part of the file format");
+
+    static uint64_t entryKey(uint64_t input_hash, uint32_t driver_id);
+    static size_t fileSize() { return sizeof(Header) + sizeof(Slot) * SLOT_COUNT; }
+    static bool hasCurrentLayout(int fd);
+    static bool replaceWithEmpty(const std::string& path);
+    // Copies a slot; false if it was being written.
+    static bool readSlot(const Slot& slot, uint64_t& key, StrategyResult& out);
+
+    int fd_;                     // kept open for the writers' flock
+    void* mapping_;
+    Slot* slots_;
+    std::mutex write_mutex_;     // flock doesn't exclude threads sharing fd_
+};
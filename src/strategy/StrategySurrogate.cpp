@@ -0,0 +1,237 @@
+#include "StrategySurrogate.h"
+#include "RaceSimulator.h"
+#include "../common/ContentHash.h"
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+namespace {
+    const char MAGIC[4] = {'F', '1', 'S', 'G'};
+
+    // Wear-rate nodes are spaced quadratically: at low rates the lap where the
+    // tires saturate moves like 1 / rate, so the table bends sharply there.
+    float rateAt(float s) {
+        return StrategySurrogate::MAX_WEAR_RATE * s * s;
+    }
+
+    // Wear nodes crowd towards 1.0 for the same reason: at low rates a small change
+    // in starting wear moves the saturation lap a long way.
+    double wearAt(double s) {
+        return 1.0 - (1.0 - s) * (1.0 - s);
+    }
+
+    bool writeAll(int fd, const void* data, size_t n) {
+        const char* p = static_cast<const char*>(data);
+        while(n > 0) {
+            ssize_t written = write(fd, p, n);
+            if(written <= 0) return false;
+            p += written;
+            n -= static_cast<size_t>(written);
+        }
+        return true;
+    }
+}
+
+float StrategySurrogate::interpolate(const float* values, uint32_t depth, float rate, float wear, uint32_t j) {
+    const uint32_t r0 = min<uint32_t>(static_cast<uint32_t>(rate), WEAR_RATE_NODES - 2);
+    const uint32_t w0 = min<uint32_t>(static_cast<uint32_t>(wear), WEAR_NODES - 2);
+    const float tr = rate - r0;
+    const float tw = wear - w0;
+
+    const float* row = values + (static_cast<size_t>(r0) * WEAR_NODES + w0) * depth + j;
+    const float a = row[0];
+    const float b = row[depth];
+    const float c = row[static_cast<size_t>(WEAR_NODES) * depth];
+    const float d = row[static_cast<size_t>(WEAR_NODES + 1) * depth];
+    return (a + (b - a) * tw) + ((c + (d - c) * tw) - (a + (b - a) * tw)) * tr;
+}
+
+uint64_t StrategySurrogate::modelHash(const RaceModel& model) {
+    ContentHash hasher;
+    hasher.u32(RaceSimulator::MODEL_VERSION);
+    hasher.u32(model.totalLaps());
+    hasher.u32(model.track().sectors);
+    hasher.f32(model.track().lap_length_km);
+    return hasher.finish();
+}
+
+bool StrategySurrogate::build(const RaceModel& model, const string& path, BuildReport* report) {
+    const uint32_t laps = model.totalLaps();
+    const uint32_t depth = laps + 1;
+    constexpr uint32_t NO_PIT = UINT32_MAX;
+
+    // One synthetic driver per wear rate on a half-node grid: even indices are table
+    // nodes, odd ones the cell centres used for validation. Fixed speed and pit
+    // loss; the table is normalized by base speed and the pit loss is added at query
+    // time.
+    const uint32_t rate_samples = 2 * WEAR_RATE_NODES - 1;
+    TrackProfile track = model.track();
+    track.tire_wear_factor = 1.0f;
+    vector<DriverProfile> drivers;
+    vector<CarProfile> cars;
+    for(uint32_t m = 0; m < rate_samples; m++) {
+        const float rate = rateAt(static_cast<float>(m) / (rate_samples - 1));
+        drivers.push_back({"surrogate", RaceModel::aggressionForWearPerLap(rate, track.tire_wear_factor), 0.8f, 0.5f, 0.5f});
+        cars.push_back({"surrogate", 1.0f, 1.0f, 1.0f, 1.0f});
+    }
+    auto probe = RaceModel::create(track, drivers, cars, laps);
+    const RaceSimulator simulator(probe);
+
+    // A(w, j) * base_speed for j = 0..laps
+    auto curve = [&](uint32_t driver, double wear, float* out) {
+        RaceSimulator::DriverSnapshot state{0, 1, 0.0, wear, 0.0, false};
+        const double base = probe->baseSpeed()[driver];
+        out[0] = 0.0f;
+        for(uint32_t j = 1; j <= laps; j++) {
+            simulator.advanceDriver(driver, state, true, NO_PIT, j);
+            out[j] = static_cast<float>(state.time_seconds * base);
+        }
+    };
+
+    vector<float> values(static_cast<size_t>(WEAR_RATE_NODES) * WEAR_NODES * depth);
+    for(uint32_t r = 0; r < WEAR_RATE_NODES; r++) {
+        for(uint32_t w = 0; w < WEAR_NODES; w++) {
+            curve(2 * r, wearAt(static_cast<double>(w) / (WEAR_NODES - 1)),
+                  values.data() + (static_cast<size_t>(r) * WEAR_NODES + w) * depth);
+        }
+    }
+
+    // Bilinear error peaks away from the nodes: check every cell centre and edge
+    // midpoint, charging each result to the cells it lies in or borders.
+    const uint32_t rate_cells = WEAR_RATE_NODES - 1;
+    const uint32_t wear_cells = WEAR_NODES - 1;
+    vector<float> cell_error(static_cast<size_t>(rate_cells) * wear_cells, 0.0f);
+    size_t validation_points = 0;
+    vector<float> exact(depth);
+    for(uint32_t m = 0; m < rate_samples; m++) {
+        for(uint32_t k = 0; k < 2 * WEAR_NODES - 1; k++) {
+            if(m % 2 == 0 && k % 2 == 0) continue;   // a node; exact by construction
+            curve(m, wearAt(static_cast<double>(k) / (2 * wear_cells)), exact.data());
+            float error = 0.0f;
+            for(uint32_t j = 0; j <= laps; j++) {
+                error = max(error, fabs(interpolate(values.data(), depth, m * 0.5f, k * 0.5f, j) - exact[j]));
+            }
+            for(uint32_t r = (m > 0 ? (m - 1) / 2 : 0); r <= min(m / 2, rate_cells - 1); r++) {
+                for(uint32_t w = (k > 0 ? (k - 1) / 2 : 0); w <= min(k / 2, wear_cells - 1); w++) {
+                    float& cell = cell_error[r * wear_cells + w];
+                    cell = max(cell, error);
+                }
+            }
+            validation_points++;
+        }
+    }
+    const float max_error = *max_element(cell_error.begin(), cell_error.end());
+
+    Header header{};
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.format_version = FORMAT_VERSION;
+    header.total_laps = laps;
+    header.sectors = model.track().sectors;
+    header.lap_length_km = model.track().lap_length_km;
+    header.wear_rate_nodes = WEAR_RATE_NODES;
+    header.wear_nodes = WEAR_NODES;
+    header.max_wear_rate = MAX_WEAR_RATE;
+    header.max_error = max_error;
+    header.model_hash = modelHash(model);
+
+    const string tmp_path = path + ".tmp";
+    int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(fd < 0) return false;
+    bool ok = writeAll(fd, &header, sizeof(header)) &&
+              writeAll(fd, values.data(), values.size() * sizeof(float)) &&
+              writeAll(fd, cell_error.data(), cell_error.size() * sizeof(float));
+    ok = close(fd) == 0 && ok;
+    if(!ok || rename(tmp_path.c_str(), path.c_str()) != 0) {
+        unlink(tmp_path.c_str());
+        return false;
+    }
+
+    if(report) *report = {fileSize(laps), validation_points, max_error};
+    return true;
+}
+
+StrategySurrogate::StrategySurrogate(shared_ptr<const RaceModel> model, const string& path)
+    : model_(move(model)), mapping_(nullptr), mapping_size_(0), values_(nullptr), cell_error_(nullptr) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if(fd < 0) return;
+
+    struct stat st;
+    const size_t expected = fileSize(model_->totalLaps());
+    if(fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) != expected) {
+        close(fd);
+        return;
+    }
+
+    void* mapping = mmap(nullptr, expected, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);   // the mapping keeps the file alive
+    if(mapping == MAP_FAILED) return;
+
+    const Header* header = static_cast<const Header*>(mapping);
+    if(memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 || header->format_version != FORMAT_VERSION ||
+       header->total_laps != model_->totalLaps() || header->sectors != model_->track().sectors ||
+       header->lap_length_km != model_->track().lap_length_km ||
+       header->wear_rate_nodes != WEAR_RATE_NODES || header->wear_nodes != WEAR_NODES ||
+       header->max_wear_rate != MAX_WEAR_RATE || header->model_hash != modelHash(*model_)) {
+        munmap(mapping, expected);
+        return;
+    }
+
+    mapping_ = mapping;
+    mapping_size_ = expected;
+    values_ = reinterpret_cast<const float*>(static_cast<const char*>(mapping) + sizeof(Header));
+    cell_error_ = values_ + static_cast<size_t>(WEAR_RATE_NODES) * WEAR_NODES * (model_->totalLaps() + 1);
+}
+
+StrategySurrogate::~StrategySurrogate() {
+    if(mapping_) munmap(mapping_, mapping_size_);
+}
+
+bool StrategySurrogate::bestStop(uint32_t driver_id, uint32_t laps_remaining, float tire_wear,
+                                 SurrogateAnswer& out) const {
+    const float wear_rate = model_->wearPerLap()[driver_id];
+    if(!values_ || wear_rate < 0.0f || wear_rate > MAX_WEAR_RATE) return false;
+
+    const uint32_t depth = model_->totalLaps() + 1;
+    const uint32_t remaining = min(laps_remaining, model_->totalLaps());
+    const float rate = sqrt(wear_rate / MAX_WEAR_RATE) * (WEAR_RATE_NODES - 1);
+    const float wear = (1.0f - sqrt(1.0f - min(max(tire_wear, 0.0f), 1.0f))) * (WEAR_NODES - 1);
+    const float base_speed = model_->baseSpeed()[driver_id];
+    const float pit_loss = model_->pitLossSeconds()[driver_id];
+
+    // Scan in normalized units; candidates differ by A terms only, so the pit loss
+    // and the 1 / base_speed scale are applied once at the end.
+    const float loss = pit_loss * base_speed;
+    float best = interpolate(values_, depth, rate, wear, remaining);   // no stop
+    float runner_up = INFINITY;
+    uint32_t best_j = 0;
+    for(uint32_t j = 1; j < remaining; j++) {
+        const float t = interpolate(values_, depth, rate, wear, j) + loss +
+                        interpolate(values_, depth, rate, 0.0f, remaining - j);
+        if(t < best) {
+            runner_up = best;
+            best = t;
+            best_j = j;
+        } else if(t < runner_up) {
+            runner_up = t;
+        }
+    }
+
+    // Each candidate sums one term from the current-wear cell and one from the fresh-tire cell
+    const uint32_t rate_cell = min<uint32_t>(static_cast<uint32_t>(rate), WEAR_RATE_NODES - 2);
+    const uint32_t wear_cell = min<uint32_t>(static_cast<uint32_t>(wear), WEAR_NODES - 2);
+    const float* errors = cell_error_ + static_cast<size_t>(rate_cell) * (WEAR_NODES - 1);
+    const float error = errors[wear_cell] + errors[0];
+    out.stop = best_j != 0;
+    out.laps_until_stop = best_j;
+    out.finish_seconds = best / base_speed;
+    out.error_seconds = error / base_speed;
+    out.decisive = runner_up - best > 2.0f * error;
+    return true;
+}
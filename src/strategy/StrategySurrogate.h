@@ -0,0 +1,98 @@
+#pragma once
+
+#include "../common/RaceModel.h"
+#include <memory>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+struct SurrogateAnswer {
+    bool stop;                  // false: running to the flag beats every stop
+    uint32_t laps_until_stop;   // pit at the start of current lap + this (1 = next lap)
+    float finish_seconds;       // time from now to the flag
+    float error_seconds;        // bound on finish_seconds' interpolation error
+    bool decisive;              // runner-up is further behind than the error bound allows
+};
+
+// Precomputed "best stop from here" answers, loaded with mmap.
+//
+// From a lap boundary with tire wear w and R laps to go, stopping after j laps costs
+// A(w, j) + pit_loss + A(0, R - j), where A(w, j) is the time to run j laps starting
+// at wear w. Travel time scales exactly with 1 / base_speed and the pit loss is the
+// same whichever lap it's taken on, so the only thing A depends on besides (w, j) is
+// the driver's wear per lap: driver and car traits, and the track's wear factor,
+// collapse into that one rate. The table stores A * base_speed on a (wear rate x
+// wear) grid for j = 0..total_laps, built offline from RaceSimulator; a query
+// bilinearly interpolates one row per j and scans the stop laps, in well under a
+// microsecond.
+//
+// The build also runs the simulator at every cell centre and edge midpoint and
+// stores each cell's worst interpolation error; an answer's error bound adds up
+// the cells it read. Tables are tied to the track geometry and race length they
+// were built for, and to the RaceSimulator::MODEL_VERSION whose physics (wear
+// curve, dead-tire speed) produced them; the constructor rejects any other.
+class StrategySurrogate {
+public:
+    static constexpr const char* DEFAULT_PATH = ".f1-strategy-surrogate";
+    static constexpr uint32_t WEAR_RATE_NODES = 33;
+    static constexpr uint32_t WEAR_NODES = 33;
+    static constexpr float MAX_WEAR_RATE = 0.1f;   // per lap; aggression 1.0 on a wear factor 2.0 track
+
+    struct BuildReport {
+        size_t table_bytes;
+        size_t validation_points;
+        float max_error;   // worst cell; seconds at a base speed of 1 kph, so divide by a driver's base speed
+    };
+
+    // Writes the table for model's track and race length to path (atomically, via
+    // rename). Returns false if the file can't be written.
+    static bool build(const RaceModel& model, const std::string& path = DEFAULT_PATH,
+                      BuildReport* report = nullptr);
+
+    StrategySurrogate(std::shared_ptr<const RaceModel> model, const std::string& path = DEFAULT_PATH);
+    ~StrategySurrogate();
+
+    StrategySurrogate(const StrategySurrogate&) = delete;
+    StrategySurrogate& operator=(const StrategySurrogate&) = delete;
+
+    // False if the file is missing, malformed or built for another track.
+    bool isOpen() const { return values_ != nullptr; }
+
+    // Best single stop for a driver at a lap boundary. False if the table isn't open
+    // or the driver's wear rate is outside the grid.
+    bool bestStop(uint32_t driver_id, uint32_t laps_remaining, float tire_wear, SurrogateAnswer& out) const;
+
+private:
+    struct Header {
+        char magic[4];            // "F1SG"
+        uint32_t format_version;
+        uint32_t total_laps;
+        uint32_t sectors;
+        float lap_length_km;
+        uint32_t wear_rate_nodes;
+        uint32_t wear_nodes;
+        float max_wear_rate;
+        float max_error;
+        uint32_t reserved;
+        uint64_t model_hash;      // modelHash() of the build
+    };
+
+    static constexpr uint32_t FORMAT_VERSION = 2;
+
+    // Identifies the simulator physics and the inputs a table is built from.
+    static uint64_t modelHash(const RaceModel& model);
+
+    static size_t fileSize(uint32_t total_laps) {
+        return sizeof(Header) + sizeof(float) * (static_cast<size_t>(WEAR_RATE_NODES) * WEAR_NODES * (total_laps + 1) +
+                                                 static_cast<size_t>(WEAR_RATE_NODES - 1) * (WEAR_NODES - 1));
+    }
+
+    // A * base_speed at fractional grid position (rate, wear) for j laps.
+    static float interpolate(const float* values, uint32_t depth, float rate, float wear, uint32_t j);
+
+    std::shared_ptr<const RaceModel> model_;
+    void* mapping_;
+    size_t mapping_size_;
+    const float* values_;       // [rate node][wear node][j]
+    const float* cell_error_;   // [rate cell][wear cell], same units as values_
+};
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "../common/types.h"
+
+// One tick of telemetry for the whole field, stored structure-of-arrays.
+// Index i is driver_id i. Reuse the same batch across ticks: once it has been
+// sized for the field, TelemetryGenerator::nextInto never allocates again.
+struct FrameBatch {
+    uint64_t timestamp_ns = 0;
+
+    std::vector<uint32_t> lap;
+    std::vector<uint8_t>  sector;
+    std::vector<uint8_t>  race_position;
+
+    std::vector<float> speed_kph;
+    std::vector<float> throttle;
+    std::vector<float> brake;
+    std::vector<float> tire_wear;
+    std::vector<float> tire_temp_c[4];   // FL, FR, RL, RR
+
+    size_t size() const { return lap.size(); }
+
+    // No-op (and no allocation) when the size is unchanged.
+    void resize(size_t n) {
+        if (n == size()) return;
+        lap.resize(n);
+        sector.resize(n);
+        race_position.resize(n);
+        speed_kph.resize(n);
+        throttle.resize(n);
+        brake.resize(n);
+        tire_wear.resize(n);
+        for (auto& temps : tire_temp_c) temps.resize(n);
+    }
+
+    TelemetryFrame frame(size_t i) const {
+        TelemetryFrame f{};
+        f.timestamp_ns = timestamp_ns;
+        f.driver_id = static_cast<uint32_t>(i);
+        f.lap = lap[i];
+        f.sector = sector[i];
+        f.race_position = race_position[i];
+        f.speed_kph = speed_kph[i];
+        f.throttle = throttle[i];
+        f.brake = brake[i];
+        f.tire_wear = tire_wear[i];
+        for (int t = 0; t < 4; t++) f.tire_temp_c[t] = tire_temp_c[t][i];
+        return f;
+    }
+
+    // Row form for the bus: subscribers, the recorder's log and replay all carry
+    // TelemetryFrame, so a tick is transposed once, here. Reuses out's capacity.
+    void toFrames(std::vector<TelemetryFrame>& out) const {
+        out.resize(size());
+        for (size_t i = 0; i < size(); i++) out[i] = frame(i);
+    }
+};
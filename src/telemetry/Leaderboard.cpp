@@ -0,0 +1,35 @@
+#include "Leaderboard.h"
+
+using namespace std;
+
+Leaderboard::Leaderboard(size_t driver_count)
+    : order_(driver_count), positions_(driver_count) {
+    for (uint32_t i = 0; i < driver_count; i++) {
+        order_[i] = i;
+        positions_[i] = static_cast<uint8_t>(i + 1);
+    }
+    overtakes_.reserve(driver_count);
+}
+
+void Leaderboard::update(const float* distances, uint64_t timestamp_ns) {
+    overtakes_.clear();
+
+    // Insertion pass: each driver bubbles up past anyone now strictly behind them.
+    for (size_t i = 1; i < order_.size(); i++) {
+        const uint32_t driver = order_[i];
+        const float distance = distances[driver];
+
+        size_t p = i;
+        while (p > 0 && distance > distances[order_[p - 1]]) {
+            const uint32_t passed = order_[p - 1];
+            order_[p] = passed;
+            positions_[passed] = static_cast<uint8_t>(p + 1);
+            overtakes_.push_back({timestamp_ns, driver, passed, static_cast<uint8_t>(p)});
+            p--;
+        }
+        if (p != i) {
+            order_[p] = driver;
+            positions_[driver] = static_cast<uint8_t>(p + 1);
+        }
+    }
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+struct OvertakeEvent {
+    uint64_t timestamp_ns;
+    uint32_t overtaking_driver;
+    uint32_t overtaken_driver;
+    uint8_t  new_position;      // position gained by overtaking_driver
+};
+
+// Running order maintained incrementally between ticks. Positions rarely change
+// in 20 ms, so an insertion pass over the previous order is ~O(n) per tick
+// instead of a full sort; every adjacent swap it makes is an overtake.
+class Leaderboard {
+public:
+    explicit Leaderboard(size_t driver_count);
+
+    // distances[i] is driver i's total race distance. Ties keep the previous order.
+    void update(const float* distances, uint64_t timestamp_ns);
+
+    uint32_t leader() const { return order_[0]; }
+    uint8_t position(uint32_t driver_id) const { return positions_[driver_id]; }
+    const std::vector<uint32_t>& order() const { return order_; }
+
+    // Overtakes detected by the last update()
+    const std::vector<OvertakeEvent>& overtakes() const { return overtakes_; }
+
+private:
+    std::vector<uint32_t> order_;       // order_[p] = driver in position p+1
+    std::vector<uint8_t> positions_;    // positions_[driver] = 1-based position
+    std::vector<OvertakeEvent> overtakes_;
+};
@@ -5,13 +5,22 @@
 using namespace std;
 
 TelemetryGenerator::TelemetryGenerator(
-    const TrackProfile& track,
-    const vector<DriverProfile>& drivers,
-    const vector<CarProfile>& cars,
-    uint32_t total_laps,
+    shared_ptr<const RaceModel> model,
     std::shared_ptr<PenaltyEnforcer> penalty_enforcer
-) : track_(track), drivers_(drivers), cars_(cars), total_laps_(total_laps), current_time_ns_(0), penalty_enforcer_(penalty_enforcer) {
-    states_.resize(drivers.size());
+) : model_(move(model)), driver_count_(model_->driverCount()), total_laps_(model_->totalLaps()), current_time_ns_(0),
+    planned_pit_laps_(make_shared<const vector<uint32_t>>(driver_count_, NO_PLANNED_STOP)), leaderboard_(driver_count_), penalty_enforcer_(penalty_enforcer), snapshot_lap_(UINT32_MAX) {
+    states_.resize(driver_count_);
+    distances_.resize(driver_count_);
+    speeds_.resize(driver_count_);
+    lanes_.moving.resize(driver_count_);
+    lanes_.tire_wear.resize(driver_count_);
+    lanes_.distance_in_lap.resize(driver_count_);
+    lanes_.lap.resize(driver_count_);
+    lanes_.sector.resize(driver_count_);
+
+    tick_params_.lap_length_km = model_->track().lap_length_km;
+    tick_params_.sector_length_km = model_->sectorLengthKm();
+    tick_params_.sectors = model_->track().sectors;
 
     for (auto &s : states_){
         s.lap = 0;
@@ -25,59 +34,85 @@ TelemetryGenerator::TelemetryGenerator(
     }
 }
 
-vector<TelemetryFrame> TelemetryGenerator::next() {
-    constexpr uint64_t tick_ns = 20'000'000ULL; // 20ms in nanoseconds
-    current_time_ns_ += tick_ns;
+void TelemetryGenerator::nextInto(FrameBatch& batch) {
+    advanceClock();
+
+    const size_t n = driver_count_;
+    batch.resize(n);
+    batch.timestamp_ns = current_time_ns_;
+
+    stepDrivers();
 
-    vector<TelemetryFrame> frames;
-    frames.reserve(drivers_.size());
+    for(uint32_t i = 0; i < n; i++) {
+        const float speed = speeds_[i];
+        const auto& state = states_[i];
+
+        batch.lap[i] = state.lap;
+        batch.sector[i] = state.sector;
+        batch.speed_kph[i] = speed;
+        batch.throttle[i] = 1.0f;
+        batch.brake[i] = 0.0f;
+        batch.tire_wear[i] = state.tire_wear;
+        const float temp = tireTemperature(state, speed);
+        for(int t = 0; t < 4; t++) {
+            batch.tire_temp_c[t][i] = temp;
+        }
+    }
 
-    for(uint32_t i = 0; i < drivers_.size(); i++) {
-        frames.push_back(generateFrame(i));
+    calculatePositions();
+    for(uint32_t i = 0; i < n; i++) {
+        batch.race_position[i] = leaderboard_.position(i);
     }
+    publishSnapshotOnNewLap();
+}
 
-    calculatePositions(frames);
+void TelemetryGenerator::publishSnapshotOnNewLap() {
+    const uint32_t leader_lap = states_[leaderboard_.leader()].lap;
+    if(leader_lap == snapshot_lap_) return;
+    snapshot_lap_ = leader_lap;
 
-    return frames;
+    auto snapshot = make_shared<RaceSnapshot>();
+    snapshot->timestamp_ns = current_time_ns_;
+    snapshot->states = states_;
+    atomic_store(&snapshot_, shared_ptr<const RaceSnapshot>(move(snapshot)));
+}
+
+void TelemetryGenerator::advanceClock() {
+    constexpr uint64_t tick_ns = 20'000'000ULL; // 20ms in nanoseconds
+    current_time_ns_ += tick_ns;
 }
 
 float TelemetryGenerator::getTotalDistance(uint32_t driver_id) const {
     const auto& s = states_[driver_id];
-    const float sector_length = track_.lap_length_km / track_.sectors;
+    const float sector_length = tick_params_.sector_length_km;
     const float sector_offset = (static_cast<float>(s.sector) - 1.0f) * sector_length;
-    return s.lap * track_.lap_length_km + sector_offset + s.distance_in_lap;
+    return s.lap * tick_params_.lap_length_km + sector_offset + s.distance_in_lap;
 }
 
-void TelemetryGenerator::calculatePositions(vector<TelemetryFrame>& frames) {
-    vector<pair<uint32_t, float>> positions;
-    for(uint32_t i = 0; i < drivers_.size(); i++) {
-        positions.push_back({i, getTotalDistance(i)});
-    }
-    sort(positions.begin(), positions.end(), [](const pair<uint32_t, float>& a, const pair<uint32_t, float>& b) {
-        return a.second > b.second;
-    });
-    for(uint32_t i = 0; i < positions.size(); i++) {
-        uint32_t driver_id = positions[i].first;
-        frames[driver_id].race_position = static_cast<uint8_t>(i + 1);
+void TelemetryGenerator::calculatePositions() {
+    // distances_ is sized once in the constructor and reused every tick.
+    for(uint32_t i = 0; i < driver_count_; i++) {
+        distances_[i] = getTotalDistance(i);
     }
+    leaderboard_.update(distances_.data(), current_time_ns_);
 }
 
-TelemetryFrame TelemetryGenerator::generateFrame(uint32_t i) {
-    auto& state = states_[i];
-    const auto& driver = drivers_[i];
-    const auto& car = cars_[i];
+float TelemetryGenerator::tireTemperature(const DriverState& state, float speed) {
+    return state.is_on_pit ? 60.0f : clamp(80.0f + speed * 0.05f, 60.0f, 120.0f);
+}
 
-    float base_threshold = 0.65f + (driver.tire_management * 0.25f);
-    float risk_adjustment = (driver.risk_tolerance - 0.5f) * 0.15f;
-    float pit_threshold = base_threshold + risk_adjustment;
+void TelemetryGenerator::updatePitState(uint32_t i, uint32_t planned_pit_lap) {
+    auto& state = states_[i];
+    const float pit_threshold = model_->pitThreshold()[i];
 
     bool should_pit = false;
-    const bool has_optimal = (optimal_strategies_.find(i) != optimal_strategies_.end());
+    // A plan that arrives after its lap has passed can't be followed; keep pitting on wear.
+    const bool has_optimal = planned_pit_lap != NO_PLANNED_STOP &&
+                             (state.has_pitted || state.lap <= planned_pit_lap);
 
     if (has_optimal) {
         // If an optimal strategy is provided, follow it exactly (and only once).
-        const uint32_t optimal_pit_lap = optimal_strategies_[i];
-        should_pit = (state.lap == optimal_pit_lap) && !state.is_on_pit && !state.has_pitted;
+        should_pit = (state.lap == planned_pit_lap) && !state.is_on_pit && !state.has_pitted;
     } else {
         // Otherwise pit based on tire wear (can happen multiple times across the race).
         should_pit = (state.tire_wear > pit_threshold) && !state.is_on_pit;
@@ -87,7 +122,7 @@ TelemetryFrame TelemetryGenerator::generateFrame(uint32_t i) {
         state.is_on_pit = true;
         if (has_optimal) state.has_pitted = true; // consume the planned pit
         state.pit_stop_start_time_ns = current_time_ns_;
-        uint64_t pit_duration = static_cast<uint64_t>((2.0f + (1.0f - car.reliability) * 1.0f) * 1e9);
+        uint64_t pit_duration = static_cast<uint64_t>(model_->pitLossSeconds()[i] * 1e9);
 
         if (penalty_enforcer_ && penalty_enforcer_->shouldServePenalty(i, current_time_ns_)) {
             // Add the configured penalty duration (in simulation time) to this pit stop.
@@ -102,71 +137,52 @@ TelemetryFrame TelemetryGenerator::generateFrame(uint32_t i) {
         state.is_on_pit = false;
         state.tire_wear = 0.0f;
     }
+}
 
-    float speed = 0.0f;
-    if (!state.is_on_pit) {
-        float driver_skill = 0.80f + driver.consistency * 0.25f;
-        speed = 220.0f * car.engine_power * driver_skill * (1.0f - state.tire_wear * 0.4f);
-    }
-
-    if (!state.is_on_pit) {
-        constexpr float tick_seconds = 0.02f;
-        constexpr float sim_speed_multiplier = 120.0f;
-        const float delta_distance_km = speed * (tick_seconds / 3600.0f) * sim_speed_multiplier;
-
-        // Tire wear scales with distance traveled (not per tick), so pit timing stays stable if sim speed changes.
-        // Tuned so typical first stops fall roughly in the 15–25 lap range depending on driver traits and track.
-        const float wear_per_lap = 0.05f * driver.aggression * track_.tire_wear_factor; // 0..~0.05 per lap
-        state.tire_wear += (delta_distance_km / track_.lap_length_km) * wear_per_lap;
-        if (state.tire_wear > 1.0f) state.tire_wear = 1.0f;
-
-        state.distance_in_lap += delta_distance_km;
-
-        float sector_length = track_.lap_length_km / track_.sectors;
-
-        while (state.distance_in_lap >= sector_length) {
-            state.distance_in_lap -= sector_length;
-            state.sector++;
+void TelemetryGenerator::stepDrivers() {
+    const size_t n = driver_count_;
 
-            if (state.sector > track_.sectors) {
-                state.sector = 1;
-                state.lap++;
-            }
-        }
+    // Pit entry/exit stays scalar: it talks to the PenaltyEnforcer per driver.
+    const auto plan = atomic_load(&planned_pit_laps_);
+    for(uint32_t i = 0; i < n; i++) {
+        updatePitState(i, (*plan)[i]);
     }
 
-    TelemetryFrame frame{};
-    frame.timestamp_ns = current_time_ns_;
-    frame.driver_id = i;
-    frame.lap = state.lap;
-    frame.sector = state.sector;
-    frame.speed_kph = speed;
-    frame.throttle = 1.0f;
-    frame.brake = 0.0f;
-    frame.tire_wear = state.tire_wear;
-    float base_temp = state.is_on_pit ? 60.0f : clamp(80.0f + speed * 0.05f, 60.0f, 120.0f);
-    for(int t = 0; t < 4; t++) {
-        frame.tire_temp_c[t] = base_temp;
+    // Gather into SoA lanes, advance the whole field at once, scatter back.
+    for(uint32_t i = 0; i < n; i++) {
+        const auto& state = states_[i];
+        lanes_.moving[i] = state.is_on_pit ? 0 : 1;
+        lanes_.tire_wear[i] = state.tire_wear;
+        lanes_.distance_in_lap[i] = state.distance_in_lap;
+        lanes_.lap[i] = state.lap;
+        lanes_.sector[i] = state.sector;
     }
 
-    return frame;
+    TickKernel::DriverLanes lanes{
+        model_->baseSpeed(), model_->wearPerLap(), lanes_.moving.data(),
+        lanes_.tire_wear.data(), lanes_.distance_in_lap.data(),
+        lanes_.lap.data(), lanes_.sector.data(), speeds_.data()
+    };
+    TickKernel::advance(tick_params_, lanes, n);
+
+    for(uint32_t i = 0; i < n; i++) {
+        auto& state = states_[i];
+        state.tire_wear = lanes_.tire_wear[i];
+        state.distance_in_lap = lanes_.distance_in_lap[i];
+        state.lap = lanes_.lap[i];
+        state.sector = static_cast<uint8_t>(lanes_.sector[i]);
+    }
 }
 
 bool TelemetryGenerator::isRaceFinished() const {
-    float max_distance = 0;
-    uint32_t leader_idx = 0;
-    
-    for(uint32_t i = 0; i < states_.size(); i++) {
-        float total_distance = getTotalDistance(i);
-        if(total_distance > max_distance) {
-            max_distance = total_distance;
-            leader_idx = i;
-        }
-    }
-    
-    return states_[leader_idx].lap >= total_laps_;
+    // The leaderboard is refreshed every tick, so the leader is already known.
+    return states_[leaderboard_.leader()].lap >= total_laps_;
 }
 
 void TelemetryGenerator::setOptimalStrategies(const std::map<uint32_t, uint32_t>& strategies) {
-    optimal_strategies_ = strategies;
+    auto plan = make_shared<vector<uint32_t>>(driver_count_, NO_PLANNED_STOP);
+    for(const auto& entry : strategies) {
+        if(entry.first < plan->size()) (*plan)[entry.first] = entry.second;
+    }
+    atomic_store(&planned_pit_laps_, shared_ptr<const vector<uint32_t>>(move(plan)));
 }
\ No newline at end of file
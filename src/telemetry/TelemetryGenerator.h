@@ -3,35 +3,79 @@
 #include <vector>
 #include <map>
 #include <cstdint>
+#include <memory>
 #include "../common/types.h"
+#include "../common/RaceModel.h"
+#include "FrameBatch.h"
+#include "Leaderboard.h"
+#include "../physics/TickKernel.h"
 #include "../race-control/PenaltyEnforcer.h"
 
 class TelemetryGenerator {
 public:
-    TelemetryGenerator(const TrackProfile& track, const std::vector<DriverProfile>& drivers, const std::vector<CarProfile>& cars, uint32_t total_laps, std::shared_ptr<PenaltyEnforcer> penalty_enforcer);
+    TelemetryGenerator(std::shared_ptr<const RaceModel> model, std::shared_ptr<PenaltyEnforcer> penalty_enforcer);
 
-    std::vector<TelemetryFrame> next();
+    // Advances one 20 ms tick and writes the field's frames into a reusable SoA batch;
+    // no heap allocation once sized.
+    void nextInto(FrameBatch& batch);
     bool isRaceFinished() const;
 
+    // Thread-safe: may be called from any thread while the race runs. The whole
+    // plan is swapped in one step and takes effect from the next tick.
     void setOptimalStrategies(const std::map<uint32_t, uint32_t>& strategies);
 
+    // Field state as of the start of the leader's current lap; republished once per
+    // lap (the only allocation after startup). Safe to call from any thread.
+    std::shared_ptr<const RaceSnapshot> latestSnapshot() const { return std::atomic_load(&snapshot_); }
+
+    // Overtakes produced by the most recent tick
+    const std::vector<OvertakeEvent>& lastOvertakes() const { return leaderboard_.overtakes(); }
+
 private:
-    TrackProfile track_;
-    std::vector<DriverProfile> drivers_;
-    std::vector<CarProfile> cars_;
+    std::shared_ptr<const RaceModel> model_;
+    size_t driver_count_;
     uint32_t total_laps_;
 
     uint64_t current_time_ns_; // simulation time
 
-    std::map<uint32_t, uint32_t> optimal_strategies_;
+    // Planned pit lap per driver (NO_PLANNED_STOP = wear-based). Immutable once
+    // published; setOptimalStrategies replaces the pointer with std::atomic_store and
+    // each tick reads it once with std::atomic_load, so a tick never sees half a plan.
+    static constexpr uint32_t NO_PLANNED_STOP = UINT32_MAX;
+    std::shared_ptr<const std::vector<uint32_t>> planned_pit_laps_;
 
     std::vector<DriverState> states_;
 
+    TickKernel::TickParams tick_params_;
+
+    // SoA scratch for TickKernel, gathered from/scattered to states_ every tick
+    struct KernelLanes {
+        std::vector<uint8_t> moving;
+        std::vector<float> tire_wear;
+        std::vector<float> distance_in_lap;
+        std::vector<uint32_t> lap;
+        std::vector<uint32_t> sector;
+    };
+    KernelLanes lanes_;
+    std::vector<float> speeds_;   // kph per driver for the current tick
+
+    // Running order, updated incrementally from distances_ every tick
+    std::vector<float> distances_;
+    Leaderboard leaderboard_;
+
     std::shared_ptr<PenaltyEnforcer> penalty_enforcer_;
 
-    TelemetryFrame generateFrame(uint32_t driver_id);
+    std::shared_ptr<const RaceSnapshot> snapshot_;
+    uint32_t snapshot_lap_;
+
+    void publishSnapshotOnNewLap();
+
+    void advanceClock();
+    void updatePitState(uint32_t driver_id, uint32_t planned_pit_lap);
+    void stepDrivers();   // pit logic + TickKernel for the whole field; fills speeds_
+    static float tireTemperature(const DriverState& state, float speed);
 
-    void calculatePositions(std::vector<TelemetryFrame>& frames);
+    void calculatePositions();
 
     float getTotalDistance(uint32_t driver_id) const;
 };
\ No newline at end of file
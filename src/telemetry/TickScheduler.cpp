@@ -0,0 +1,92 @@
+#include "TickScheduler.h"
+#include <thread>
+#include <iomanip>
+
+using namespace std;
+
+LatenessHistogram::LatenessHistogram() : buckets_{}, count_(0), total_ns_(0), max_ns_(0) {}
+
+void LatenessHistogram::record(chrono::nanoseconds lateness) {
+    const uint64_t ns = lateness.count() > 0 ? static_cast<uint64_t>(lateness.count()) : 0;
+    uint64_t us = ns / 1000;
+
+    int bucket = 0;
+    while (us > 0 && bucket < BUCKETS - 1) {
+        us >>= 1;
+        bucket++;
+    }
+
+    buckets_[bucket]++;
+    count_++;
+    total_ns_ += ns;
+    if (ns > max_ns_) max_ns_ = ns;
+}
+
+double LatenessHistogram::meanMicros() const {
+    return count_ ? (total_ns_ / 1000.0) / count_ : 0.0;
+}
+
+double LatenessHistogram::percentileMicros(double p) const {
+    if (count_ == 0) return 0.0;
+    const uint64_t rank = static_cast<uint64_t>(p / 100.0 * (count_ - 1)) + 1;
+    uint64_t seen = 0;
+    for (int b = 0; b < BUCKETS; b++) {
+        seen += buckets_[b];
+        if (seen >= rank) return static_cast<double>(1ULL << b);
+    }
+    return maxMicros();
+}
+
+void LatenessHistogram::print(ostream& out) const {
+    out << fixed << setprecision(1)
+        << "Tick lateness (us): mean " << meanMicros()
+        << "  p50 <" << percentileMicros(50)
+        << "  p99 <" << percentileMicros(99)
+        << "  max " << maxMicros()
+        << "  (" << count_ << " ticks)\n";
+
+    for (int b = 0; b < BUCKETS; b++) {
+        if (buckets_[b] == 0) continue;
+        const uint64_t lo = b == 0 ? 0 : (1ULL << (b - 1));
+        out << "  [" << setw(7) << lo << ", " << setw(7) << (1ULL << b) << ") "
+            << setw(8) << buckets_[b] << "\n";
+    }
+}
+
+TickScheduler::TickScheduler(chrono::nanoseconds period, CatchUpPolicy policy, chrono::nanoseconds spin_window)
+    : period_(period), policy_(policy), spin_window_(spin_window), tick_index_(0), skipped_ticks_(0) {
+    start();
+}
+
+void TickScheduler::start() {
+    start_ = Clock::now();
+    tick_index_ = 0;
+}
+
+void TickScheduler::waitNextTick() {
+    tick_index_++;
+    const Clock::time_point deadline = start_ + period_ * tick_index_;
+
+    Clock::time_point now = Clock::now();
+    if (now < deadline) {
+        if (deadline - now > spin_window_) {
+            this_thread::sleep_until(deadline - spin_window_);
+        }
+        while ((now = Clock::now()) < deadline) {
+            // spin out the last stretch; sleep_until alone overshoots by the scheduler quantum
+        }
+    }
+
+    const auto late = chrono::duration_cast<chrono::nanoseconds>(now - deadline);
+    lateness_.record(late);
+
+    const int64_t missed = late / period_;
+    if (missed == 0) return;
+
+    // CATCH_UP needs nothing here: the next deadlines are already in the past, so the
+    // following calls return immediately until the producer is back on schedule.
+    if (policy_ == CatchUpPolicy::SKIP || missed > MAX_CATCH_UP_TICKS) {
+        tick_index_ += missed;
+        skipped_ticks_ += static_cast<uint64_t>(missed);
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+// What to do when the producer falls behind its deadlines.
+//   CATCH_UP:  run the missed ticks back-to-back until simulated time matches wall time again
+//   SKIP:      drop the missed deadlines and resume on the next one (steady cadence, sim time slips)
+enum class CatchUpPolicy {
+    CATCH_UP,
+    SKIP
+};
+
+// Log2 histogram of tick lateness in microseconds: bucket 0 is < 1 us,
+// bucket k is [2^(k-1), 2^k) us, the last bucket is open-ended.
+class LatenessHistogram {
+public:
+    static constexpr int BUCKETS = 24;
+
+    LatenessHistogram();
+
+    void record(std::chrono::nanoseconds lateness);
+
+    uint64_t count() const { return count_; }
+    double meanMicros() const;
+    double maxMicros() const { return max_ns_ / 1000.0; }
+    // Upper bound of the bucket containing the p-th percentile (p in [0, 100]).
+    double percentileMicros(double p) const;
+
+    void print(std::ostream& out) const;
+
+private:
+    uint64_t buckets_[BUCKETS];
+    uint64_t count_;
+    uint64_t total_ns_;
+    uint64_t max_ns_;
+};
+
+// Absolute-deadline tick pacing: tick k is due at start + k * period, so time spent
+// generating and publishing a tick is absorbed instead of added on top of the sleep.
+// Sleeps until just before the deadline, then spins the last stretch for low jitter.
+class TickScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    TickScheduler(std::chrono::nanoseconds period, CatchUpPolicy policy,
+                  std::chrono::nanoseconds spin_window = std::chrono::microseconds(200));
+
+    void start();
+    void waitNextTick();
+
+    const LatenessHistogram& lateness() const { return lateness_; }
+    uint64_t skippedTicks() const { return skipped_ticks_; }
+
+private:
+    // Beyond this many missed ticks CATCH_UP gives up and rebases instead of bursting.
+    static constexpr int64_t MAX_CATCH_UP_TICKS = 50;
+
+    std::chrono::nanoseconds period_;
+    CatchUpPolicy policy_;
+    std::chrono::nanoseconds spin_window_;
+
+    Clock::time_point start_;
+    int64_t tick_index_;
+
+    LatenessHistogram lateness_;
+    uint64_t skipped_ticks_;
+};